@@ -0,0 +1,669 @@
+/*
+ * dependencyindex.cpp
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "dependencyindex.h"
+
+#include "jsonscanner.h"
+#include "savefile.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QUrl>
+#include <QXmlStreamReader>
+
+#include <algorithm>
+
+namespace Tiled {
+
+namespace {
+
+const int IndexVersion = 1;
+
+const char * const dependencyTypeNames[] = {
+    "tileset",
+    "template",
+    "image",
+};
+
+QString dependencyTypeToString(DependencyIndex::DependencyType type)
+{
+    return QLatin1String(dependencyTypeNames[type]);
+}
+
+bool dependencyTypeFromString(const QString &string, DependencyIndex::DependencyType &type)
+{
+    for (int i = 0; i < int(sizeof(dependencyTypeNames) / sizeof(dependencyTypeNames[0])); ++i) {
+        if (string == QLatin1String(dependencyTypeNames[i])) {
+            type = static_cast<DependencyIndex::DependencyType>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+QStringList sorted(const QSet<QString> &set)
+{
+    QStringList list = set.values();
+    std::sort(list.begin(), list.end());
+    return list;
+}
+
+/**
+ * Adds a reference found in a file located in \a dir. References to
+ * resources or to files provided by extensions are not indexed.
+ */
+void addReference(DependencyIndex::Entry &entry,
+                  DependencyIndex::DependencyType type,
+                  const QDir &dir,
+                  const QString &reference)
+{
+    if (reference.isEmpty())
+        return;
+
+    QString fileName;
+
+    const QUrl url(reference);
+    if (url.isLocalFile())
+        fileName = QDir::cleanPath(url.toLocalFile());
+    else if (url.scheme().length() > 1)  // single letters are drive letters
+        return;
+    else
+        fileName = QDir::cleanPath(dir.filePath(reference));
+
+    for (const DependencyIndex::Dependency &dependency : qAsConst(entry.dependencies))
+        if (dependency.type == type && dependency.fileName == fileName)
+            return;
+
+    entry.dependencies.append(DependencyIndex::Dependency { type, fileName });
+}
+
+bool parseXml(QIODevice *device, const QDir &dir, DependencyIndex::Entry &entry)
+{
+    QXmlStreamReader xml(device);
+
+    if (!xml.readNextStartElement())
+        return false;
+
+    if (xml.name() != QLatin1String("map") &&
+            xml.name() != QLatin1String("tileset") &&
+            xml.name() != QLatin1String("template"))
+        return false;
+
+    while (!xml.atEnd()) {
+        if (!xml.isStartElement()) {
+            xml.readNext();
+            continue;
+        }
+
+        const auto name = xml.name();
+        const QXmlStreamAttributes atts = xml.attributes();
+
+        if (name == QLatin1String("data")) {
+            // Skip the tile layer data, which makes up most of a map
+            xml.skipCurrentElement();
+        } else if (name == QLatin1String("tileset")) {
+            addReference(entry, DependencyIndex::TilesetReference, dir,
+                         atts.value(QLatin1String("source")).toString());
+        } else if (name == QLatin1String("image")) {
+            addReference(entry, DependencyIndex::ImageReference, dir,
+                         atts.value(QLatin1String("source")).toString());
+        } else if (name == QLatin1String("object")) {
+            addReference(entry, DependencyIndex::TemplateReference, dir,
+                         atts.value(QLatin1String("template")).toString());
+            if (!atts.value(QLatin1String("type")).isEmpty())
+                entry.usesObjectTypes = true;
+        } else if (name == QLatin1String("tile")) {
+            if (!atts.value(QLatin1String("type")).isEmpty())
+                entry.usesObjectTypes = true;
+        }
+
+        xml.readNext();
+    }
+
+    return true;
+}
+
+/**
+ * Returns the string given by the raw JSON value from \a begin to \a end,
+ * or a null string when the value is not a string.
+ */
+QString jsonString(const char *begin, const char *end)
+{
+    if (begin == end || *begin != '"')
+        return QString();
+
+    const QByteArray value = QByteArray::fromRawData(begin, static_cast<int>(end - begin));
+    if (!value.contains('\\'))
+        return QString::fromUtf8(begin + 1, value.size() - 2);
+
+    // Leave unescaping to QJsonDocument
+    const QJsonDocument document = QJsonDocument::fromJson('[' + value + ']');
+    return document.array().at(0).toString();
+}
+
+void parseJson(const char *begin, const char *end, QLatin1String key,
+               const QDir &dir, DependencyIndex::Entry &entry);
+
+/**
+ * Looks for references in a member of a JSON object, which was found as the
+ * value of the given \a key.
+ */
+void parseJsonMember(QLatin1String key, QLatin1String memberKey,
+                     const char *valueBegin, const char *valueEnd,
+                     const QDir &dir, DependencyIndex::Entry &entry)
+{
+    const bool isTileset = key == QLatin1String("tileset") || key == QLatin1String("tilesets");
+    const bool isTyped = key == QLatin1String("object") || key == QLatin1String("objects") ||
+            key == QLatin1String("tiles");
+
+    if (memberKey == QLatin1String("source")) {
+        if (isTileset) {
+            addReference(entry, DependencyIndex::TilesetReference, dir,
+                         jsonString(valueBegin, valueEnd));
+        }
+    } else if (memberKey == QLatin1String("type")) {
+        if (isTyped && !jsonString(valueBegin, valueEnd).isEmpty())
+            entry.usesObjectTypes = true;
+    } else if (memberKey == QLatin1String("image")) {
+        addReference(entry, DependencyIndex::ImageReference, dir,
+                     jsonString(valueBegin, valueEnd));
+    } else if (memberKey == QLatin1String("template")) {
+        addReference(entry, DependencyIndex::TemplateReference, dir,
+                     jsonString(valueBegin, valueEnd));
+    } else if (memberKey == QLatin1String("data") ||
+               memberKey == QLatin1String("chunks") ||
+               memberKey == QLatin1String("properties")) {
+        // Skip the tile layer data, which makes up most of a map, as well
+        // as custom properties
+    } else if (*valueBegin == '{' || *valueBegin == '[') {
+        parseJson(valueBegin, valueEnd, memberKey, dir, entry);
+    }
+}
+
+/**
+ * Looks for references in the raw JSON value, found as the value of the
+ * given \a key. Array elements are treated as if they were the value of
+ * the key.
+ *
+ * Values are scanned rather than parsed, so the values that are skipped,
+ * like the tile layer data, are never parsed.
+ */
+void parseJson(const char *begin, const char *end, QLatin1String key,
+               const QDir &dir, DependencyIndex::Entry &entry)
+{
+    if (*begin == '[') {
+        auto element = [&] (const char *elementBegin, const char *elementEnd) {
+            parseJson(elementBegin, elementEnd, key, dir, entry);
+            return true;
+        };
+        JsonScanner::forEachElement(begin, end, element);
+        return;
+    }
+
+    auto member = [&] (QLatin1String memberKey, const char *valueBegin, const char *valueEnd) {
+        parseJsonMember(key, memberKey, valueBegin, valueEnd, dir, entry);
+        return true;
+    };
+    JsonScanner::forEachMember(begin, end, member);
+}
+
+bool parseJson(QFile &file, const QDir &dir, DependencyIndex::Entry &entry)
+{
+    QByteArray contents;
+    const char *pos = nullptr;
+    qint64 size = file.size();
+
+    if (uchar *mapped = size > 0 ? file.map(0, size) : nullptr) {
+        pos = reinterpret_cast<const char*>(mapped);
+    } else {
+        contents = file.readAll();
+        pos = contents.constData();
+        size = contents.size();
+    }
+
+    const char *end = pos + size;
+    JsonScanner::skipByteOrderMark(pos, end);
+    JsonScanner::skipWhitespace(pos, end);
+
+    // The type is usually one of the last members, so the references are
+    // collected before knowing whether the file is to be indexed
+    QString type;
+    auto member = [&] (QLatin1String key, const char *valueBegin, const char *valueEnd) {
+        if (key == QLatin1String("type"))
+            type = jsonString(valueBegin, valueEnd);
+        else
+            parseJsonMember(QLatin1String(), key, valueBegin, valueEnd, dir, entry);
+        return true;
+    };
+
+    if (!JsonScanner::forEachMember(pos, end, member))
+        return false;
+
+    return type == QLatin1String("map") ||
+            type == QLatin1String("tileset") ||
+            type == QLatin1String("template");
+}
+
+bool parseFile(const QString &fileName, DependencyIndex::Entry &entry)
+{
+    const QFileInfo fileInfo(fileName);
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    entry.lastModified = fileInfo.lastModified().toMSecsSinceEpoch();
+
+    if (fileInfo.suffix().compare(QLatin1String("json"), Qt::CaseInsensitive) == 0)
+        return parseJson(file, fileInfo.absoluteDir(), entry);
+
+    return parseXml(&file, fileInfo.absoluteDir(), entry);
+}
+
+struct ParseResult
+{
+    bool ok = false;
+    DependencyIndex::Entry entry;
+};
+
+class ParseFileTask : public QRunnable
+{
+public:
+    ParseFileTask(const QString &fileName, ParseResult &result)
+        : mFileName(fileName)
+        , mResult(result)
+    {}
+
+    void run() override
+    {
+        mResult.ok = parseFile(mFileName, mResult.entry);
+    }
+
+private:
+    const QString mFileName;
+    ParseResult &mResult;
+};
+
+} // anonymous namespace
+
+/**
+ * Indexes all maps, tilesets and templates in the given \a folders and
+ * their subfolders. Files that did not change since they were last indexed
+ * are skipped, and files that no longer exist are removed from the index.
+ */
+void DependencyIndex::scan(const QStringList &folders)
+{
+    QStringList staleFiles;
+    QSet<QString> foundFiles;
+    QStringList prefixes;
+
+    for (const QString &folder : folders) {
+        const QString folderPath = QDir(folder).absolutePath();
+        prefixes.append(folderPath + QLatin1Char('/'));
+
+        QDirIterator it(folderPath, QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            const QString fileName = QDir::cleanPath(it.next());
+            if (!isIndexable(fileName))
+                continue;
+
+            foundFiles.insert(fileName);
+
+            auto entry = mEntries.constFind(fileName);
+            if (entry == mEntries.constEnd() ||
+                    entry->lastModified != it.fileInfo().lastModified().toMSecsSinceEpoch()) {
+                staleFiles.append(fileName);
+            }
+        }
+    }
+
+    const QStringList indexedFiles = mEntries.keys();
+    for (const QString &fileName : indexedFiles) {
+        if (foundFiles.contains(fileName))
+            continue;
+
+        const bool inScannedFolder = std::any_of(prefixes.begin(), prefixes.end(),
+                                                 [&] (const QString &prefix) {
+            return fileName.startsWith(prefix);
+        });
+
+        if (inScannedFolder)
+            remove(fileName);
+    }
+
+    parse(staleFiles);
+}
+
+/**
+ * Indexes the given files again, for example after they were changed.
+ * Files that no longer exist are removed from the index.
+ */
+void DependencyIndex::update(const QStringList &fileNames)
+{
+    QStringList existingFiles;
+
+    for (const QString &fileName : fileNames) {
+        const QString cleanFileName = QDir::cleanPath(QFileInfo(fileName).absoluteFilePath());
+        if (QFileInfo::exists(cleanFileName) && isIndexable(cleanFileName))
+            existingFiles.append(cleanFileName);
+        else
+            remove(cleanFileName);
+    }
+
+    parse(existingFiles);
+}
+
+void DependencyIndex::remove(const QString &fileName)
+{
+    auto it = mEntries.find(fileName);
+    if (it == mEntries.end())
+        return;
+
+    removeDependents(fileName, *it);
+    mEntries.erase(it);
+}
+
+void DependencyIndex::clear()
+{
+    mEntries.clear();
+    mDependents.clear();
+    mObjectTypesDependents.clear();
+}
+
+/**
+ * Returns the indexed files, sorted by name.
+ */
+QStringList DependencyIndex::files() const
+{
+    QStringList fileNames = mEntries.keys();
+    std::sort(fileNames.begin(), fileNames.end());
+    return fileNames;
+}
+
+/**
+ * Returns the files directly referenced by the given file.
+ */
+QVector<DependencyIndex::Dependency> DependencyIndex::dependencies(const QString &fileName) const
+{
+    return mEntries.value(fileName).dependencies;
+}
+
+/**
+ * Returns the files directly referring to the given file.
+ */
+QStringList DependencyIndex::dependents(const QString &fileName) const
+{
+    QSet<QString> fileNames = mDependents.value(fileName);
+
+    if (!mObjectTypesFile.isEmpty() && fileName == mObjectTypesFile)
+        fileNames.unite(mObjectTypesDependents);
+
+    return sorted(fileNames);
+}
+
+/**
+ * Returns all files that directly or indirectly depend on the given file.
+ * For example, a map uses a tileset when one of its objects is an instance
+ * of a template referring to that tileset.
+ */
+QStringList DependencyIndex::usages(const QString &fileName) const
+{
+    QSet<QString> found;
+    QStringList queue { fileName };
+
+    while (!queue.isEmpty()) {
+        const QString current = queue.takeFirst();
+        const QStringList fileNames = dependents(current);
+
+        for (const QString &dependent : fileNames) {
+            if (!found.contains(dependent)) {
+                found.insert(dependent);
+                queue.append(dependent);
+            }
+        }
+    }
+
+    found.remove(fileName);
+    return sorted(found);
+}
+
+/**
+ * Returns the references to files that do not exist, sorted by the file
+ * they were found in.
+ */
+QVector<DependencyIndex::BrokenLink> DependencyIndex::brokenLinks() const
+{
+    QVector<BrokenLink> links;
+    QHash<QString, bool> exists;
+
+    const QStringList fileNames = files();
+    for (const QString &fileName : fileNames) {
+        const Entry &entry = mEntries[fileName];
+
+        for (const Dependency &dependency : entry.dependencies) {
+            auto it = exists.find(dependency.fileName);
+            if (it == exists.end())
+                it = exists.insert(dependency.fileName, QFileInfo::exists(dependency.fileName));
+
+            if (!it.value())
+                links.append(BrokenLink { fileName, dependency });
+        }
+    }
+
+    return links;
+}
+
+/**
+ * Saves the index to the given file, so that it can be loaded again
+ * without having to parse all files.
+ */
+bool DependencyIndex::save(const QString &fileName, QString *error) const
+{
+    QJsonArray filesArray;
+
+    const QStringList fileNames = files();
+    for (const QString &filePath : fileNames) {
+        const Entry &entry = mEntries[filePath];
+
+        QJsonArray dependenciesArray;
+        for (const Dependency &dependency : entry.dependencies) {
+            QJsonObject dependencyObject;
+            dependencyObject.insert(QLatin1String("type"), dependencyTypeToString(dependency.type));
+            dependencyObject.insert(QLatin1String("file"), dependency.fileName);
+            dependenciesArray.append(dependencyObject);
+        }
+
+        QJsonObject fileObject;
+        fileObject.insert(QLatin1String("file"), filePath);
+        fileObject.insert(QLatin1String("lastModified"), double(entry.lastModified));
+        if (entry.usesObjectTypes)
+            fileObject.insert(QLatin1String("usesObjectTypes"), true);
+        if (!dependenciesArray.isEmpty())
+            fileObject.insert(QLatin1String("dependencies"), dependenciesArray);
+
+        filesArray.append(fileObject);
+    }
+
+    QJsonObject indexObject;
+    indexObject.insert(QLatin1String("version"), IndexVersion);
+    indexObject.insert(QLatin1String("files"), filesArray);
+
+    SaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error)
+            *error = QCoreApplication::translate("File Errors", "Could not open file for writing.");
+        return false;
+    }
+
+    file.device()->write(QJsonDocument(indexObject).toJson(QJsonDocument::Compact));
+
+    if (file.error() != QFileDevice::NoError || !file.commit()) {
+        if (error)
+            *error = file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Replaces the index with the one saved in the given file. Use scan() or
+ * update() afterwards to index any files that changed since it was saved.
+ */
+bool DependencyIndex::load(const QString &fileName, QString *error)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error)
+            *error = QCoreApplication::translate("File Errors", "Could not open file for reading.");
+        return false;
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (parseError.error != QJsonParseError::NoError) {
+        if (error)
+            *error = parseError.errorString();
+        return false;
+    }
+
+    const QJsonObject indexObject = document.object();
+    if (indexObject.value(QLatin1String("version")).toInt() != IndexVersion) {
+        if (error)
+            *error = QCoreApplication::translate("File Errors", "Unsupported dependency index version.");
+        return false;
+    }
+
+    clear();
+
+    const QJsonArray filesArray = indexObject.value(QLatin1String("files")).toArray();
+    for (const QJsonValue &fileValue : filesArray) {
+        const QJsonObject fileObject = fileValue.toObject();
+        const QString filePath = fileObject.value(QLatin1String("file")).toString();
+        if (filePath.isEmpty())
+            continue;
+
+        Entry entry;
+        entry.lastModified = qint64(fileObject.value(QLatin1String("lastModified")).toDouble());
+        entry.usesObjectTypes = fileObject.value(QLatin1String("usesObjectTypes")).toBool();
+
+        const QJsonArray dependenciesArray = fileObject.value(QLatin1String("dependencies")).toArray();
+        for (const QJsonValue &dependencyValue : dependenciesArray) {
+            const QJsonObject dependencyObject = dependencyValue.toObject();
+
+            Dependency dependency;
+            if (!dependencyTypeFromString(dependencyObject.value(QLatin1String("type")).toString(), dependency.type))
+                continue;
+
+            dependency.fileName = dependencyObject.value(QLatin1String("file")).toString();
+            entry.dependencies.append(dependency);
+        }
+
+        addDependents(filePath, entry);
+        mEntries.insert(filePath, entry);
+    }
+
+    return true;
+}
+
+/**
+ * Returns whether the given file has an extension used by one of the
+ * indexed formats.
+ */
+bool DependencyIndex::isIndexable(const QString &fileName)
+{
+    const QString suffix = QFileInfo(fileName).suffix().toLower();
+    return suffix == QLatin1String("tmx") ||
+            suffix == QLatin1String("tsx") ||
+            suffix == QLatin1String("tx") ||
+            suffix == QLatin1String("json");
+}
+
+/**
+ * Parses the given files in parallel and replaces their entries in the
+ * index. Files that could not be parsed or that are not maps, tilesets or
+ * templates are removed from the index.
+ */
+void DependencyIndex::parse(const QStringList &fileNames)
+{
+    if (fileNames.isEmpty())
+        return;
+
+    QVector<ParseResult> results(fileNames.size());
+
+    QThreadPool pool;
+    for (int i = 0; i < fileNames.size(); ++i)
+        pool.start(new ParseFileTask(fileNames.at(i), results[i]));
+    pool.waitForDone();
+
+    for (int i = 0; i < fileNames.size(); ++i) {
+        const QString &fileName = fileNames.at(i);
+        remove(fileName);
+
+        const ParseResult &result = results.at(i);
+        if (result.ok) {
+            addDependents(fileName, result.entry);
+            mEntries.insert(fileName, result.entry);
+        }
+    }
+}
+
+void DependencyIndex::addDependents(const QString &fileName, const Entry &entry)
+{
+    for (const Dependency &dependency : entry.dependencies)
+        mDependents[dependency.fileName].insert(fileName);
+
+    if (entry.usesObjectTypes)
+        mObjectTypesDependents.insert(fileName);
+}
+
+void DependencyIndex::removeDependents(const QString &fileName, const Entry &entry)
+{
+    for (const Dependency &dependency : entry.dependencies) {
+        auto it = mDependents.find(dependency.fileName);
+        if (it == mDependents.end())
+            continue;
+
+        it->remove(fileName);
+        if (it->isEmpty())
+            mDependents.erase(it);
+    }
+
+    mObjectTypesDependents.remove(fileName);
+}
+
+} // namespace Tiled
@@ -0,0 +1,121 @@
+/*
+ * dependencyindex.h
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "tiled_global.h"
+
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+namespace Tiled {
+
+/**
+ * Keeps track of which maps, tilesets and templates refer to which other
+ * files, without loading any of them.
+ *
+ * Files are scanned with a lightweight parse that only looks at references
+ * (tilesets, templates and images) and at whether objects or tiles have a
+ * type, in which case the file depends on the object types file. Only the
+ * TMX, TSX, TX and JSON formats are indexed.
+ *
+ * The index can be saved and loaded again, in which case only files that
+ * were modified in the meantime need to be parsed again.
+ */
+class TILEDSHARED_EXPORT DependencyIndex
+{
+public:
+    enum DependencyType {
+        TilesetReference,
+        TemplateReference,
+        ImageReference,
+    };
+
+    struct Dependency
+    {
+        DependencyType type;
+        QString fileName;
+    };
+
+    struct BrokenLink
+    {
+        QString fileName;
+        Dependency dependency;
+    };
+
+    struct Entry
+    {
+        qint64 lastModified = 0;
+        bool usesObjectTypes = false;
+        QVector<Dependency> dependencies;
+    };
+
+    void setObjectTypesFile(const QString &fileName);
+    const QString &objectTypesFile() const;
+
+    void scan(const QStringList &folders);
+    void update(const QStringList &fileNames);
+    void remove(const QString &fileName);
+    void clear();
+
+    QStringList files() const;
+    QVector<Dependency> dependencies(const QString &fileName) const;
+    QStringList dependents(const QString &fileName) const;
+    QStringList usages(const QString &fileName) const;
+    QVector<BrokenLink> brokenLinks() const;
+
+    bool save(const QString &fileName, QString *error = nullptr) const;
+    bool load(const QString &fileName, QString *error = nullptr);
+
+    static bool isIndexable(const QString &fileName);
+
+private:
+    void parse(const QStringList &fileNames);
+    void addDependents(const QString &fileName, const Entry &entry);
+    void removeDependents(const QString &fileName, const Entry &entry);
+
+    QString mObjectTypesFile;
+    QHash<QString, Entry> mEntries;
+    QHash<QString, QSet<QString>> mDependents;
+    QSet<QString> mObjectTypesDependents;
+};
+
+
+inline void DependencyIndex::setObjectTypesFile(const QString &fileName)
+{
+    mObjectTypesFile = fileName;
+}
+
+inline const QString &DependencyIndex::objectTypesFile() const
+{
+    return mObjectTypesFile;
+}
+
+} // namespace Tiled
@@ -28,6 +28,8 @@
 
 #include "fileformat.h"
 
+#include <QFile>
+
 namespace Tiled {
 
 FileFormat::FileFormat(QObject *parent)
@@ -45,4 +47,26 @@ bool FileFormat::hasCapabilities(Capabilities caps) const
     return (capabilities() & caps) == caps;
 }
 
+bool FileFormat::supportsFileHeader(const QString &fileName,
+                                    const QByteArray &header) const
+{
+    Q_UNUSED(header)
+    return supportsFile(fileName);
+}
+
+/**
+ * Returns the first FileHeaderSize bytes of the given file, or less when the
+ * file is smaller. Returns an empty array when the file can't be read.
+ *
+ * Used to check the contents of a file against all formats while reading
+ * the file only once.
+ */
+QByteArray FileFormat::readFileHeader(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+    return file.read(FileHeaderSize);
+}
+
 } // namespace Tiled
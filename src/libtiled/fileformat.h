@@ -83,11 +83,27 @@ public:
      */
     virtual bool supportsFile(const QString &fileName) const = 0;
 
+    /**
+     * Returns whether this map format supports reading the given file, with
+     * \a header containing the start of the file as returned by
+     * readFileHeader().
+     *
+     * Since the header is read only once for all formats, formats that need
+     * to look at the contents of a file should override this function.
+     * The default implementation calls supportsFile().
+     */
+    virtual bool supportsFileHeader(const QString &fileName,
+                                    const QByteArray &header) const;
+
     /**
      * Returns the error to be shown to the user if an error occurred while
      * trying to read or write a file.
      */
     virtual QString errorString() const = 0;
+
+    enum { FileHeaderSize = 4096 };
+
+    static QByteArray readFileHeader(const QString &fileName);
 };
 
 } // namespace Tiled
@@ -161,13 +161,13 @@ QByteArray GidMapper::encodeLayerData(const TileLayer &tileLayer,
     tileData.reserve(bounds.width() * bounds.height() * 4);
 
     for (int y = bounds.top(); y <= bounds.bottom(); ++y) {
-        for (int x = bounds.left(); x <= bounds.right(); ++x) {
-            const unsigned gid = cellToGid(tileLayer.cellAt(x, y));
+        tileLayer.forEachCellInRow(y, bounds.left(), bounds.right() + 1, [&] (int, const Cell &cell) {
+            const unsigned gid = cellToGid(cell);
             tileData.append(static_cast<char>(gid));
             tileData.append(static_cast<char>(gid >> 8));
             tileData.append(static_cast<char>(gid >> 16));
             tileData.append(static_cast<char>(gid >> 24));
-        }
+        });
     }
 
     if (format == Map::Base64Gzip)
@@ -40,12 +40,14 @@ void GroupLayer::addLayer(std::unique_ptr<Layer> layer)
 {
     adoptLayer(*layer);
     mLayers.append(layer.release());
+    updateSiblingIndices(mLayers, mLayers.size() - 1);
 }
 
 void GroupLayer::insertLayer(int index, Layer *layer)
 {
     adoptLayer(*layer);
     mLayers.insert(index, layer);
+    updateSiblingIndices(mLayers, index);
 }
 
 void GroupLayer::adoptLayer(Layer &layer)
@@ -63,6 +65,7 @@ Layer *GroupLayer::takeLayerAt(int index)
     Layer *layer = mLayers.takeAt(index);
     layer->setMap(nullptr);
     layer->setParentLayer(nullptr);
+    updateSiblingIndices(mLayers, index);
     return layer;
 }
 
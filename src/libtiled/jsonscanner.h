@@ -0,0 +1,252 @@
+/*
+ * jsonscanner.h
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+#include <cstring>
+
+namespace Tiled {
+
+/**
+ * Functions for scanning JSON data without parsing it.
+ *
+ * Members and elements are reported along with the bounds of their raw
+ * values, and nested values are skipped without being parsed. This is a lot
+ * cheaper than a full parse when only a few values are needed, like when
+ * detecting the kind of file or looking for references to other files.
+ */
+namespace JsonScanner {
+
+inline void skipWhitespace(const char *&pos, const char *end)
+{
+    while (pos != end && (*pos == ' ' || *pos == '\t' || *pos == '\n' || *pos == '\r'))
+        ++pos;
+}
+
+/**
+ * Skips the UTF-8 byte order mark, which QJsonDocument accepts as well.
+ */
+inline void skipByteOrderMark(const char *&pos, const char *end)
+{
+    if (end - pos >= 3 && memcmp(pos, "\xEF\xBB\xBF", 3) == 0)
+        pos += 3;
+}
+
+/**
+ * Skips the string starting at \a pos, including the quotes.
+ */
+inline bool skipString(const char *&pos, const char *end)
+{
+    ++pos;  // opening quote
+    while (pos != end) {
+        const char c = *pos++;
+        if (c == '\\') {
+            if (pos != end)
+                ++pos;
+        } else if (c == '"') {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Skips the value starting at \a pos, without parsing nested values.
+ */
+inline bool skipValue(const char *&pos, const char *end)
+{
+    if (*pos == '"')
+        return skipString(pos, end);
+
+    if (*pos == '{' || *pos == '[') {
+        int depth = 0;
+        while (pos != end) {
+            switch (*pos) {
+            case '"':
+                if (!skipString(pos, end))
+                    return false;
+                continue;
+            case '{':
+            case '[':
+                ++depth;
+                break;
+            case '}':
+            case ']':
+                if (--depth == 0) {
+                    ++pos;
+                    return true;
+                }
+                break;
+            }
+            ++pos;
+        }
+        return false;
+    }
+
+    while (pos != end && !strchr(",}] \t\r\n", *pos))
+        ++pos;
+    return true;
+}
+
+/**
+ * Calls \a function with the key and the bounds of the raw value of each
+ * member of the JSON object starting at \a pos, until it returns false.
+ * Nothing is reported when the value at \a pos is not an object.
+ *
+ * When \a reportIncomplete is true, a member whose value is cut off by the
+ * end of the data is reported as well, with an empty value.
+ *
+ * Returns false when the data ended before the end of the object was
+ * reached, which happens when it is only the start of a file.
+ */
+template<typename Function>
+bool forEachMember(const char *pos, const char *end, Function &function,
+                   bool reportIncomplete = false)
+{
+    if (pos == end)
+        return false;
+    if (*pos != '{')
+        return true;
+    ++pos;
+
+    while (true) {
+        skipWhitespace(pos, end);
+        if (pos == end)
+            return false;
+        if (*pos != '"')
+            return true;
+
+        const char *keyBegin = pos + 1;
+        if (!skipString(pos, end))
+            return false;
+        const QLatin1String key(keyBegin, static_cast<int>(pos - 1 - keyBegin));
+
+        skipWhitespace(pos, end);
+        if (pos == end)
+            return false;
+        if (*pos != ':')
+            return true;
+        ++pos;
+        skipWhitespace(pos, end);
+        if (pos == end)
+            return false;
+
+        const char *valueBegin = pos;
+        if (!skipValue(pos, end)) {
+            if (reportIncomplete)
+                function(key, valueBegin, valueBegin);
+            return false;
+        }
+
+        if (!function(key, valueBegin, pos))
+            return true;
+
+        skipWhitespace(pos, end);
+        if (pos != end && *pos == ',')
+            ++pos;
+    }
+}
+
+/**
+ * Calls \a function with the bounds of each element of the JSON array
+ * starting at \a pos, until it returns false. Nothing is reported when the
+ * value at \a pos is not an array.
+ *
+ * Returns false when the data ended before the end of the array was reached.
+ */
+template<typename Function>
+bool forEachElement(const char *pos, const char *end, Function &function)
+{
+    if (pos == end)
+        return false;
+    if (*pos != '[')
+        return true;
+    ++pos;
+
+    while (true) {
+        skipWhitespace(pos, end);
+        if (pos == end)
+            return false;
+        if (*pos == ']')
+            return true;
+
+        const char *valueBegin = pos;
+        if (!skipValue(pos, end))
+            return false;
+
+        if (!function(valueBegin, pos))
+            return true;
+
+        skipWhitespace(pos, end);
+        if (pos != end && *pos == ',')
+            ++pos;
+    }
+}
+
+/**
+ * Calls \a function with the key and value of each member of the top-level
+ * JSON object in the given data, until it returns false. The value is only
+ * passed for string values. A member whose value is cut off by the end of
+ * the data is still reported, without its value.
+ *
+ * When \a jsonp is true, a JSONP prefix is skipped.
+ *
+ * Returns false when the data ended before a decision was reached, which
+ * happens when it is only the start of a file.
+ */
+template<typename Function>
+bool forEachTopLevelMember(const char *pos, const char *end, bool jsonp, Function &function)
+{
+    skipByteOrderMark(pos, end);
+
+    if (jsonp && pos != end && *pos != '{') {
+        // Scan past JSONP prefix; look for an open curly at the start of the line
+        const QByteArray data = QByteArray::fromRawData(pos, static_cast<int>(end - pos));
+        const int i = data.indexOf("\n{");
+        if (i < 0)
+            return false;
+        pos += i;
+    }
+
+    skipWhitespace(pos, end);
+
+    auto member = [&] (QLatin1String key, const char *valueBegin, const char *valueEnd) {
+        QLatin1String value;
+        if (valueBegin != valueEnd && *valueBegin == '"')
+            value = QLatin1String(valueBegin + 1, static_cast<int>(valueEnd - valueBegin) - 2);
+        return function(key, value);
+    };
+
+    return forEachMember(pos, end, member, true);
+}
+
+} // namespace JsonScanner
+} // namespace Tiled
@@ -56,10 +56,22 @@ Layer::Layer(TypeFlag type, const QString &name, int x, int y) :
     mVisible(true),
     mMap(nullptr),
     mParentLayer(nullptr),
+    mSiblingIndex(-1),
     mLocked(false)
 {
 }
 
+/**
+ * Sets the name of this layer.
+ */
+void Layer::setName(const QString &name)
+{
+    mName = name;
+
+    if (mMap && !mParentLayer)
+        mMap->invalidateLayerNameIndex();
+}
+
 void Layer::resetIds()
 {
     mId = 0;        // reset out own ID
@@ -157,11 +169,32 @@ int Layer::depth() const
  */
 int Layer::siblingIndex() const
 {
+    const QList<Layer*> *siblings;
     if (mParentLayer)
-        return mParentLayer->layers().indexOf(const_cast<Layer*>(this));
-    if (mMap)
-        return mMap->layers().indexOf(const_cast<Layer*>(this));
-    return 0;
+        siblings = &mParentLayer->layers();
+    else if (mMap)
+        siblings = &mMap->layers();
+    else
+        return 0;
+
+    // The cached index is kept up to date when layers are inserted or
+    // removed, but we fall back to a search in case it got out of sync.
+    if (mSiblingIndex < 0 || mSiblingIndex >= siblings->size() ||
+            siblings->at(mSiblingIndex) != this) {
+        mSiblingIndex = siblings->indexOf(const_cast<Layer*>(this));
+    }
+
+    return mSiblingIndex;
+}
+
+/**
+ * Updates the cached sibling index of the given \a layers, starting at
+ * index \a from. Should be called after inserting or removing layers.
+ */
+void Layer::updateSiblingIndices(const QList<Layer *> &layers, int from)
+{
+    for (int i = from; i < layers.size(); ++i)
+        layers.at(i)->mSiblingIndex = i;
 }
 
 /**
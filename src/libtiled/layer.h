@@ -96,10 +96,7 @@ public:
      */
     const QString &name() const { return mName; }
 
-    /**
-     * Sets the name of this layer.
-     */
-    void setName(const QString &name) { mName = name; }
+    void setName(const QString &name);
 
     /**
      * Returns the opacity of this layer.
@@ -258,6 +255,8 @@ protected:
     virtual void setMap(Map *map) { mMap = map; }
     void setParentLayer(GroupLayer *groupLayer) { mParentLayer = groupLayer; }
 
+    static void updateSiblingIndices(const QList<Layer*> &layers, int from);
+
     Layer *initializeClone(Layer *clone) const;
 
     QString mName;
@@ -271,6 +270,7 @@ protected:
     bool mVisible;
     Map *mMap;
     GroupLayer *mParentLayer;
+    mutable int mSiblingIndex;
     bool mLocked;
 
     friend class Map;
@@ -1,6 +1,7 @@
 INCLUDEPATH += $$PWD
 
 SOURCES += $$PWD/compression.cpp \
+    $$PWD/dependencyindex.cpp \
     $$PWD/filesystemwatcher.cpp \
     $$PWD/fileformat.cpp \
     $$PWD/gidmapper.cpp \
@@ -37,6 +38,7 @@ SOURCES += $$PWD/compression.cpp \
     $$PWD/tileanimationdriver.cpp \
     $$PWD/tiled.cpp \
     $$PWD/tilelayer.cpp \
+    $$PWD/tileremapping.cpp \
     $$PWD/tileset.cpp \
     $$PWD/tilesetformat.cpp \
     $$PWD/tilesetmanager.cpp \
@@ -45,6 +47,7 @@ SOURCES += $$PWD/compression.cpp \
     $$PWD/worldmanager.cpp
 HEADERS += $$PWD/compression.h \
     $$PWD/containerhelpers.h \
+    $$PWD/dependencyindex.h \
     $$PWD/filesystemwatcher.h \
     $$PWD/fileformat.h \
     $$PWD/gidmapper.h \
@@ -55,6 +58,7 @@ HEADERS += $$PWD/compression.h \
     $$PWD/imagelayer.h \
     $$PWD/imagereference.h \
     $$PWD/isometricrenderer.h \
+    $$PWD/jsonscanner.h \
     $$PWD/layer.h \
     $$PWD/logginginterface.h \
     $$PWD/map.h \
@@ -83,6 +87,7 @@ HEADERS += $$PWD/compression.h \
     $$PWD/tiled.h \
     $$PWD/tiled_global.h \
     $$PWD/tilelayer.h \
+    $$PWD/tileremapping.h \
     $$PWD/tileset.h \
     $$PWD/tilesetformat.h \
     $$PWD/tilesetmanager.h \
@@ -62,6 +62,7 @@ Map::Map(Orientation orientation,
     mStaggerIndex(StaggerOdd),
     mChunkSize(CHUNK_SIZE, CHUNK_SIZE),
     mDrawMarginsDirty(true),
+    mLayersByNameDirty(true),
     mLayerDataFormat(Base64Zlib),
     mNextLayerId(1),
     mNextObjectId(1)
@@ -197,16 +198,34 @@ void Map::addLayer(Layer *layer)
 {
     adoptLayer(*layer);
     mLayers.append(layer);
+    Layer::updateSiblingIndices(mLayers, mLayers.size() - 1);
+    invalidateLayerNameIndex();
 }
 
 int Map::indexOfLayer(const QString &layerName, int layerTypes) const
 {
-    for (int index = 0; index < mLayers.size(); index++)
-        if (layerAt(index)->name() == layerName
-                && (layerTypes & layerAt(index)->layerType()))
-            return index;
+    if (mLayersByNameDirty) {
+        mLayersByName.clear();
+        for (Layer *layer : mLayers)
+            mLayersByName.insert(layer->name(), layer);
+        mLayersByNameDirty = false;
+    }
+
+    // Several layers may share the same name, so look for the lowest index
+    int index = -1;
+
+    auto it = mLayersByName.constFind(layerName);
+    for (; it != mLayersByName.constEnd() && it.key() == layerName; ++it) {
+        const Layer *layer = it.value();
+        if (!(layerTypes & layer->layerType()))
+            continue;
 
-    return -1;
+        const int layerIndex = layer->siblingIndex();
+        if (index == -1 || layerIndex < index)
+            index = layerIndex;
+    }
+
+    return index;
 }
 
 Layer *Map::findLayer(const QString &name, int layerTypes) const
@@ -222,6 +241,8 @@ void Map::insertLayer(int index, Layer *layer)
 {
     adoptLayer(*layer);
     mLayers.insert(index, layer);
+    Layer::updateSiblingIndices(mLayers, index);
+    invalidateLayerNameIndex();
 }
 
 void Map::adoptLayer(Layer &layer)
@@ -239,6 +260,8 @@ Layer *Map::takeLayerAt(int index)
 {
     Layer *layer = mLayers.takeAt(index);
     layer->setMap(nullptr);
+    Layer::updateSiblingIndices(mLayers, index);
+    invalidateLayerNameIndex();
     return layer;
 }
 
@@ -313,6 +336,26 @@ QSet<SharedTileset> Map::usedTilesets() const
     return tilesets;
 }
 
+/**
+ * Computes how many times each tile is used by the tile layers and tile
+ * objects of this map. Tiles that are not used are not included.
+ */
+QHash<const Tile*, int> Map::tileUsage() const
+{
+    QHash<const Tile*, int> usage;
+
+    for (Layer *layer : tileLayers())
+        static_cast<TileLayer*>(layer)->countTileUsage(usage);
+
+    for (Layer *layer : objectGroups()) {
+        for (const MapObject *object : static_cast<ObjectGroup*>(layer)->objects())
+            if (Tile *tile = object->cell().tile())
+                ++usage[tile];
+    }
+
+    return usage;
+}
+
 bool Map::isTilesetUsed(const Tileset *tileset) const
 {
     for (const Layer *layer : mLayers)
@@ -342,6 +385,7 @@ std::unique_ptr<Map> Map::clone() const
         clone->setMap(o.get());
         o->mLayers.append(clone);
     }
+    Layer::updateSiblingIndices(o->mLayers, 0);
     o->mTilesets = mTilesets;
     o->mLayerDataFormat = mLayerDataFormat;
     o->mNextLayerId = mNextLayerId;
@@ -36,6 +36,7 @@
 
 #include <QColor>
 #include <QList>
+#include <QMultiHash>
 #include <QMargins>
 #include <QSharedPointer>
 #include <QSize>
@@ -411,6 +412,8 @@ public:
      */
     QSet<SharedTileset> usedTilesets() const;
 
+    QHash<const Tile*, int> tileUsage() const;
+
     /**
      * Returns a list of MapObjects to be updated in the map scene
      */
@@ -479,8 +482,10 @@ signals:
 
 private:
     friend class GroupLayer;    // so it can call adoptLayer
+    friend class Layer;         // so it can call invalidateLayerNameIndex
 
     void adoptLayer(Layer &layer);
+    void invalidateLayerNameIndex() { mLayersByNameDirty = true; }
 
     void recomputeDrawMargins() const;
 
@@ -500,6 +505,8 @@ private:
     mutable QMargins mDrawMargins;
     mutable bool mDrawMarginsDirty;
     QList<Layer*> mLayers;
+    mutable QMultiHash<QString, Layer*> mLayersByName;
+    mutable bool mLayersByNameDirty;
     QVector<SharedTileset> mTilesets;
     LayerDataFormat mLayerDataFormat;
     int mNextLayerId;
@@ -30,9 +30,106 @@
 
 #include "map.h"
 #include "mapreader.h"
+#include "savefile.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QRunnable>
+#include <QSet>
+#include <QThreadPool>
 
 namespace Tiled {
 
+namespace {
+
+struct WriteResult
+{
+    bool ok = false;
+    QString error;
+};
+
+class WriteFileTask : public QRunnable
+{
+public:
+    WriteFileTask(const MapFormat::OutputFile &file, WriteResult &result)
+        : mFile(file)
+        , mResult(result)
+    {}
+
+    void run() override
+    {
+        SaveFile file(mFile.fileName);
+
+        if (!file.open(mFile.mode)) {
+            mResult.error = QCoreApplication::translate("File Errors", "Could not open file for writing.");
+            return;
+        }
+
+        if (!mFile.write(file.device(), mResult.error))
+            return;
+
+        if (file.error() != QFileDevice::NoError) {
+            mResult.error = file.errorString();
+            return;
+        }
+
+        if (!file.commit()) {
+            mResult.error = file.errorString();
+            return;
+        }
+
+        mResult.ok = true;
+    }
+
+private:
+    const MapFormat::OutputFile &mFile;
+    WriteResult &mResult;
+};
+
+} // anonymous namespace
+
+/**
+ * Writes the given independent \a files in parallel, using a pool of worker
+ * threads. Each file is committed separately, so that a failure to write
+ * one of the files does not affect the others.
+ *
+ * Meant for formats that write a separate file for each layer or tileset.
+ * The file names need to be unique, since the files are written at the same
+ * time.
+ *
+ * Returns whether all files were written successfully. Otherwise, \a error
+ * is set to the errors of all files that failed.
+ */
+bool MapFormat::writeFiles(const QVector<OutputFile> &files, QString &error)
+{
+#ifndef QT_NO_DEBUG
+    QSet<QString> fileNames;
+    for (const OutputFile &file : files) {
+        Q_ASSERT_X(!fileNames.contains(file.fileName), "MapFormat::writeFiles", "duplicate file name");
+        fileNames.insert(file.fileName);
+    }
+#endif
+
+    QVector<WriteResult> results(files.size());
+
+    QThreadPool pool;
+    for (int i = 0; i < files.size(); ++i)
+        pool.start(new WriteFileTask(files.at(i), results[i]));
+    pool.waitForDone();
+
+    QStringList errors;
+    for (int i = 0; i < files.size(); ++i) {
+        const WriteResult &result = results.at(i);
+        if (!result.ok) {
+            errors.append(QStringLiteral("%1: %2").arg(QDir::toNativeSeparators(files.at(i).fileName),
+                                                       result.error));
+        }
+    }
+
+    error = errors.join(QLatin1Char('\n'));
+    return errors.isEmpty();
+}
+
 std::unique_ptr<Map> readMap(const QString &fileName, QString *error)
 {
     // Try the first registered map format that claims to support the file
@@ -71,9 +168,10 @@ std::unique_ptr<Map> readMap(const QString &fileName, QString *error)
 
 MapFormat *findSupportingMapFormat(const QString &fileName)
 {
+    const QByteArray header = FileFormat::readFileHeader(fileName);
     const auto mapFormats = PluginManager::objects<MapFormat>();
     for (MapFormat *format : mapFormats)
-        if (format->supportsFile(fileName))
+        if (format->supportsFileHeader(fileName, header))
             return format;
     return nullptr;
 }
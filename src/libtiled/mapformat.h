@@ -32,10 +32,13 @@
 #include "map.h"
 #include "pluginmanager.h"
 
+#include <QIODevice>
 #include <QObject>
 #include <QStringList>
 #include <QMap>
+#include <QVector>
 
+#include <functional>
 #include <memory>
 
 namespace Tiled {
@@ -84,6 +87,25 @@ public:
      */
     virtual bool write(const Map *map, const QString &fileName,
                        Options options = Options()) = 0;
+
+    /**
+     * One of the files written by writeFiles().
+     */
+    struct OutputFile
+    {
+        QString fileName;
+
+        /**
+         * Writes the contents of the file to the given device. Returns
+         * false and sets the error on failure. May be called from any
+         * thread.
+         */
+        std::function<bool (QIODevice *device, QString &error)> write;
+
+        QIODevice::OpenMode mode = QIODevice::WriteOnly | QIODevice::Text;
+    };
+
+    static bool writeFiles(const QVector<OutputFile> &files, QString &error);
 };
 
 } // namespace Tiled
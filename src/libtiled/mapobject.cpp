@@ -260,13 +260,10 @@ Alignment MapObject::alignment(const Map *map) const
  */
 QColor MapObject::effectiveColor() const
 {
-    const QString effectiveType = this->effectiveType();
-
     // See if this object type has a color associated with it
-    for (const ObjectType &type : Object::objectTypes()) {
-        if (type.name.compare(effectiveType, Qt::CaseInsensitive) == 0)
-            return type.color;
-    }
+    const QColor typeColor = Object::objectTypeColor(effectiveType());
+    if (typeColor.isValid())
+        return typeColor;
 
     // If not, get color from object group
     if (mObjectGroup && mObjectGroup->color().isValid())
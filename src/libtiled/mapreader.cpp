@@ -69,7 +69,8 @@ class MapReaderPrivate
 public:
     explicit MapReaderPrivate(MapReader *mapReader):
         p(mapReader),
-        mReadingExternalTileset(false)
+        mReadingExternalTileset(false),
+        mLoadImages(true)
     {}
 
     std::unique_ptr<Map> readMap(QIODevice *device, const QString &path);
@@ -145,6 +146,7 @@ private:
     std::unique_ptr<Map> mMap;
     GidMapper mGidMapper;
     bool mReadingExternalTileset;
+    bool mLoadImages;
 
     QXmlStreamReader xml;
 };
@@ -305,7 +307,7 @@ std::unique_ptr<Map> MapReaderPrivate::readMap()
         // Try to load the tileset images for embedded tilesets
         auto tilesets = mMap->tilesets();
         for (SharedTileset &tileset : tilesets) {
-            if (!tileset->isCollection() && tileset->fileName().isEmpty())
+            if (mLoadImages && !tileset->isCollection() && tileset->fileName().isEmpty())
                 tileset->loadImage();
         }
 
@@ -505,7 +507,9 @@ void MapReaderPrivate::readTilesetTile(Tileset &tileset)
             tile->mergeProperties(readProperties());
         } else if (xml.name() == QLatin1String("image")) {
             ImageReference imageReference = readImage();
-            if (imageReference.hasImage()) {
+            if (imageReference.hasImage() && !mLoadImages) {
+                tile->setImageSource(imageReference.source);
+            } else if (imageReference.hasImage()) {
                 QPixmap image = imageReference.create();
                 if (image.isNull()) {
                     if (imageReference.source.isEmpty())
@@ -1068,7 +1072,14 @@ void MapReaderPrivate::readImageLayerImage(ImageLayer &imageLayer)
 {
     Q_ASSERT(xml.isStartElement() && xml.name() == QLatin1String("image"));
 
-    imageLayer.loadFromImage(readImage());
+    const ImageReference imageReference = readImage();
+
+    if (mLoadImages) {
+        imageLayer.loadFromImage(imageReference);
+    } else {
+        imageLayer.setTransparentColor(imageReference.transparentColor);
+        imageLayer.setSource(imageReference.source);
+    }
 }
 
 std::unique_ptr<MapObject> MapReaderPrivate::readObject()
@@ -1094,7 +1105,7 @@ std::unique_ptr<MapObject> MapReaderPrivate::readObject()
 
     if (!templateFileName.isEmpty()) { // This object is a template instance
         const QString absoluteFileName = p->resolveReference(templateFileName, mPath);
-        auto objectTemplate = TemplateManager::instance()->loadObjectTemplate(absoluteFileName);
+        auto objectTemplate = p->loadObjectTemplate(absoluteFileName);
         object->setObjectTemplate(objectTemplate);
     }
 
@@ -1373,7 +1384,7 @@ std::unique_ptr<Map> MapReader::readMap(const QString &fileName)
 SharedTileset MapReader::readTileset(QIODevice *device, const QString &path)
 {
     SharedTileset tileset = d->readTileset(device, path);
-    if (tileset && !tileset->isCollection())
+    if (tileset && !tileset->isCollection() && d->mLoadImages)
         tileset->loadImage();
 
     return tileset;
@@ -1411,6 +1422,11 @@ QString MapReader::errorString() const
     return d->errorString();
 }
 
+void MapReader::setLoadImages(bool loadImages)
+{
+    d->mLoadImages = loadImages;
+}
+
 QString MapReader::resolveReference(const QString &reference,
                                     const QDir &mapDir)
 {
@@ -1424,3 +1440,8 @@ SharedTileset MapReader::readExternalTileset(const QString &source,
 {
     return TilesetManager::instance()->loadTileset(source, error);
 }
+
+ObjectTemplate *MapReader::loadObjectTemplate(const QString &fileName)
+{
+    return TemplateManager::instance()->loadObjectTemplate(fileName);
+}
@@ -95,6 +95,16 @@ public:
      */
     QString errorString() const;
 
+    /**
+     * Sets whether images are loaded while reading. When disabled, tilesets,
+     * tiles and image layers only refer to their images, which can be loaded
+     * later, for example using Tileset::loadImage().
+     *
+     * This allows reading a map on a thread other than the GUI thread, since
+     * images are loaded as QPixmap. Enabled by default.
+     */
+    void setLoadImages(bool loadImages);
+
     std::unique_ptr<ObjectTemplate> readObjectTemplate(QIODevice *device, const QString &path = QString());
     std::unique_ptr<ObjectTemplate> readObjectTemplate(const QString &fileName);
 
@@ -117,6 +127,15 @@ protected:
     virtual SharedTileset readExternalTileset(const QString &source,
                                               QString *error);
 
+    /**
+     * Called when an object refers to a template while a map is loaded.
+     * The default implementation loads the template through the
+     * TemplateManager, which owns it.
+     *
+     * The returned template needs to stay alive as long as the map.
+     */
+    virtual ObjectTemplate *loadObjectTemplate(const QString &fileName);
+
 private:
     Q_DISABLE_COPY(MapReader)
 
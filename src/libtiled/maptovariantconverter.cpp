@@ -710,9 +710,12 @@ void MapToVariantConverter::addTileLayerData(QVariantMap &variant,
     case Map::XML:
     case Map::CSV: {
         QVariantList tileVariants;
-        for (int y = bounds.top(); y <= bounds.bottom(); ++y)
-            for (int x = bounds.left(); x <= bounds.right(); ++x)
-                tileVariants << mGidMapper.cellToGid(tileLayer.cellAt(x, y));
+        tileVariants.reserve(bounds.width() * bounds.height());
+        for (int y = bounds.top(); y <= bounds.bottom(); ++y) {
+            tileLayer.forEachCellInRow(y, bounds.left(), bounds.right() + 1, [&] (int, const Cell &cell) {
+                tileVariants << mGidMapper.cellToGid(cell);
+            });
+        }
 
         variant[QLatin1String("data")] = tileVariants;
         break;
@@ -640,13 +640,13 @@ void MapWriterPrivate::writeTileLayerData(QXmlStreamWriter &w,
 {
     if (mLayerDataFormat == Map::XML) {
         for (int y = bounds.top(); y <= bounds.bottom(); y++) {
-            for (int x = bounds.left(); x <= bounds.right(); x++) {
-                const unsigned gid = mGidMapper.cellToGid(tileLayer.cellAt(x, y));
+            tileLayer.forEachCellInRow(y, bounds.left(), bounds.right() + 1, [&] (int, const Cell &cell) {
+                const unsigned gid = mGidMapper.cellToGid(cell);
                 w.writeStartElement(QLatin1String("tile"));
                 if (gid != 0)
                     w.writeAttribute(QLatin1String("gid"), QString::number(gid));
                 w.writeEndElement();
-            }
+            });
         }
     } else if (mLayerDataFormat == Map::CSV) {
         QString chunkData;
@@ -655,12 +655,12 @@ void MapWriterPrivate::writeTileLayerData(QXmlStreamWriter &w,
             chunkData.append(QLatin1Char('\n'));
 
         for (int y = bounds.top(); y <= bounds.bottom(); y++) {
-            for (int x = bounds.left(); x <= bounds.right(); x++) {
-                const unsigned gid = mGidMapper.cellToGid(tileLayer.cellAt(x, y));
+            tileLayer.forEachCellInRow(y, bounds.left(), bounds.right() + 1, [&] (int x, const Cell &cell) {
+                const unsigned gid = mGidMapper.cellToGid(cell);
                 chunkData.append(QString::number(gid));
                 if (x != bounds.right() || y != bounds.bottom())
                     chunkData.append(QLatin1Char(','));
-            }
+            });
             if (!mMinimize)
                 chunkData.append(QLatin1Char('\n'));
         }
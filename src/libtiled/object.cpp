@@ -31,11 +31,11 @@
 #include "mapobject.h"
 #include "tile.h"
 
-#include "qtcompat_p.h"
-
 namespace Tiled {
 
 ObjectTypes Object::mObjectTypes;
+QHash<QString, Properties> Object::mObjectTypeProperties;
+QHash<QString, QColor> Object::mObjectTypeColors;
 
 Object::~Object()
 {}
@@ -83,20 +83,54 @@ QVariant Object::inheritedProperty(const QString &name) const
         return QVariant();
     }
 
-    if (!objectType.isEmpty()) {
-        for (const ObjectType &type : qAsConst(mObjectTypes)) {
-            if (type.name == objectType)
-                if (type.defaultProperties.contains(name))
-                    return type.defaultProperties.value(name);
-        }
-    }
+    if (!objectType.isEmpty())
+        return objectTypeProperties(objectType).value(name);
 
     return QVariant();
 }
 
+/**
+ * Sets the object types and builds the lookup tables used to find the
+ * properties and color of a type by name.
+ */
 void Object::setObjectTypes(const ObjectTypes &objectTypes)
 {
     mObjectTypes = objectTypes;
+    mObjectTypeProperties.clear();
+    mObjectTypeColors.clear();
+
+    for (const ObjectType &type : objectTypes) {
+        // When several types share a name, the first one takes precedence
+        Properties &properties = mObjectTypeProperties[type.name];
+        for (auto it = type.defaultProperties.begin(), it_end = type.defaultProperties.end(); it != it_end; ++it)
+            if (!properties.contains(it.key()))
+                properties.insert(it.key(), it.value());
+
+        const QString foldedName = type.name.toCaseFolded();
+        if (!mObjectTypeColors.contains(foldedName))
+            mObjectTypeColors.insert(foldedName, type.color);
+    }
+}
+
+/**
+ * Returns the default properties of the object type with the given \a name,
+ * combined over all types with that name.
+ */
+const Properties &Object::objectTypeProperties(const QString &name)
+{
+    static const Properties noProperties;
+
+    auto it = mObjectTypeProperties.constFind(name);
+    return it != mObjectTypeProperties.constEnd() ? it.value() : noProperties;
+}
+
+/**
+ * Returns the color of the object type with the given \a name, compared
+ * case-insensitively, or an invalid color when there is no such type.
+ */
+QColor Object::objectTypeColor(const QString &name)
+{
+    return mObjectTypeColors.value(name.toCaseFolded());
 }
 
 } // namespace Tiled
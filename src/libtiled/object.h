@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <QHash>
 #include <QObject>
 
 #include "properties.h"
@@ -140,11 +141,16 @@ public:
     static const ObjectTypes &objectTypes()
     { return mObjectTypes; }
 
+    static const Properties &objectTypeProperties(const QString &name);
+    static QColor objectTypeColor(const QString &name);
+
 private:
     const TypeId mTypeId;
     Properties mProperties;
 
     static ObjectTypes mObjectTypes;
+    static QHash<QString, Properties> mObjectTypeProperties;
+    static QHash<QString, QColor> mObjectTypeColors;
 };
 
 
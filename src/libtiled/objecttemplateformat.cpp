@@ -48,9 +48,10 @@ std::unique_ptr<ObjectTemplate> readObjectTemplate(const QString &fileName, QStr
 
 ObjectTemplateFormat *findSupportingTemplateFormat(const QString &fileName)
 {
+    const QByteArray header = FileFormat::readFileHeader(fileName);
     const auto formats = PluginManager::objects<ObjectTemplateFormat>();
     for (ObjectTemplateFormat *format : formats)
-        if (format->supportsFile(fileName))
+        if (format->supportsFileHeader(fileName, header))
             return format;
     return nullptr;
 }
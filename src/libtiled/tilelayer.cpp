@@ -33,6 +33,7 @@
 #include "hex.h"
 
 #include <algorithm>
+#include <atomic>
 #include <memory>
 
 #include <QSet>
@@ -41,6 +42,47 @@ using namespace Tiled;
 
 Cell Cell::empty;
 
+static std::atomic<quint64> latestChunkRevision(0);
+
+static quint64 nextChunkRevision()
+{
+    return ++latestChunkRevision;
+}
+
+// FNV-1a is used for the chunk hashes since unlike qHash it isn't seeded,
+// which keeps the hashes stable between sessions.
+static const quint64 fnvOffsetBasis = 14695981039346656037ULL;
+static const quint64 fnvPrime = 1099511628211ULL;
+
+static quint64 fnv1a(quint64 hash, const void *data, size_t size)
+{
+    auto bytes = static_cast<const uchar*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= fnvPrime;
+    }
+    return hash;
+}
+
+static quint64 tilesetHash(const Tileset *tileset)
+{
+    if (!tileset)
+        return 0;
+
+    const QString &name = tileset->name();
+    return fnv1a(fnvOffsetBasis, name.constData(),
+                 static_cast<size_t>(name.size()) * sizeof(QChar));
+}
+
+Chunk::Chunk()
+    : mGrid(CHUNK_SIZE * CHUNK_SIZE)
+    , mRevision(0)
+    , mHash(0)
+    , mChanged(true)
+    , mHashDirty(true)
+{
+}
+
 QRegion Chunk::region(std::function<bool (const Cell &)> condition) const
 {
     QRegion region;
@@ -68,6 +110,7 @@ void Chunk::setCell(int x, int y, const Cell &cell)
     int index = x + y * CHUNK_SIZE;
 
     mGrid[index] = cell;
+    touch();
 }
 
 bool Chunk::isEmpty() const
@@ -94,17 +137,97 @@ bool Chunk::hasCell(std::function<bool (const Cell &)> condition) const
 void Chunk::removeReferencesToTileset(Tileset *tileset)
 {
     for (int i = 0, i_end = mGrid.size(); i < i_end; ++i) {
-        if (mGrid.at(i).tileset() == tileset)
+        if (mGrid.at(i).tileset() == tileset) {
             mGrid.replace(i, Cell::empty);
+            touch();
+        }
     }
 }
 
 void Chunk::replaceReferencesToTileset(Tileset *oldTileset, Tileset *newTileset)
 {
+    if (!hasCell([=] (const Cell &cell) { return cell.tileset() == oldTileset; }))
+        return;
+
     for (Cell &cell : mGrid) {
         if (cell.tileset() == oldTileset)
             cell.setTile(newTileset, cell.tileId());
     }
+
+    touch();
+}
+
+/**
+ * Returns a 64-bit hash of the contents of this chunk. The hash is computed
+ * when needed and cached until the chunk changes.
+ *
+ * Tilesets are identified by their name, so the hash depends neither on
+ * where a map was loaded into memory nor on where its files are stored.
+ */
+quint64 Chunk::hash() const
+{
+    if (!mHashDirty)
+        return mHash;
+
+    quint64 hash = fnvOffsetBasis;
+    const Tileset *lastTileset = nullptr;
+    quint64 lastTilesetHash = 0;
+
+    for (const Cell &cell : mGrid) {
+        if (cell.tileset() != lastTileset) {
+            lastTileset = cell.tileset();
+            lastTilesetHash = tilesetHash(lastTileset);
+        }
+
+        const qint32 values[2] = {
+            cell.isEmpty() ? -1 : cell.tileId(),
+            (cell.flippedHorizontally() << 0) |
+            (cell.flippedVertically() << 1) |
+            (cell.flippedAntiDiagonally() << 2) |
+            (cell.rotatedHexagonal120() << 3)
+        };
+
+        hash = fnv1a(hash, &lastTilesetHash, sizeof(lastTilesetHash));
+        hash = fnv1a(hash, values, sizeof(values));
+    }
+
+    mHash = hash;
+    mHashDirty = false;
+    return hash;
+}
+
+/**
+ * Returns the revision at which this chunk was last changed.
+ *
+ * A chunk that changed since the last call takes a new revision here.
+ */
+quint64 Chunk::revision() const
+{
+    if (mChanged) {
+        mRevision = nextChunkRevision();
+        mChanged = false;
+    }
+    return mRevision;
+}
+
+/**
+ * Returns the latest revision given to any chunk. Chunks changed after this
+ * call will have a higher revision.
+ *
+ * Since chunks take their revision lazily, a chunk changed before this call
+ * may still take a higher revision. Call this function after
+ * TileLayer::changedChunks() to make sure the chunks of that layer are
+ * included.
+ */
+quint64 Chunk::currentRevision()
+{
+    return latestChunkRevision;
+}
+
+void Chunk::touch()
+{
+    mChanged = true;
+    mHashDirty = true;
 }
 
 TileLayer::TileLayer(const QString &name, int x, int y, int width, int height)
@@ -112,6 +235,7 @@ TileLayer::TileLayer(const QString &name, int x, int y, int width, int height)
     , mWidth(width)
     , mHeight(height)
     , mUsedTilesetsDirty(false)
+    , mCellOccurrencesDirty(true)
 {
 }
 
@@ -168,6 +292,99 @@ QRegion TileLayer::region(std::function<bool (const Cell &)> condition) const
     return region;
 }
 
+/**
+ * Calculates the region of cells in this tile layer that are equal to the
+ * given \a cell.
+ *
+ * For non-empty cells, the region is looked up in an index of the cell
+ * occurrences per chunk. This index is built on first use and is kept up to
+ * date by setCell().
+ */
+QRegion TileLayer::cellRegion(const Cell &cell) const
+{
+    if (cell.isEmpty())
+        return region([&] (const Cell &other) { return other == cell; });
+
+    const CellOccurrences occurrences = cellOccurrences().value(cell);
+
+    // Process the chunks row by row, so that the rectangles can be passed
+    // to QRegion::setRects in the required y-x-banded order
+    QVector<QPoint> chunkPositions;
+    chunkPositions.reserve(occurrences.size());
+    for (auto it = occurrences.begin(), it_end = occurrences.end(); it != it_end; ++it)
+        chunkPositions.append(it.key());
+
+    std::sort(chunkPositions.begin(), chunkPositions.end(), [] (QPoint a, QPoint b) {
+        return a.y() < b.y() || (a.y() == b.y() && a.x() < b.x());
+    });
+
+    QVector<QRect> rects;
+
+    for (int first = 0, last = 0; first < chunkPositions.size(); first = last) {
+        const int chunkY = chunkPositions.at(first).y();
+        while (last < chunkPositions.size() && chunkPositions.at(last).y() == chunkY)
+            ++last;
+
+        for (int y = 0; y < CHUNK_SIZE; ++y) {
+            const int bandStart = rects.size();
+
+            for (int i = first; i < last; ++i) {
+                const QPoint chunkPos = chunkPositions.at(i);
+                const ChunkOccurrences &bits = occurrences[chunkPos];
+
+                int x = 0;
+                while (x < CHUNK_SIZE) {
+                    if (!bits.test(x + y * CHUNK_SIZE)) {
+                        ++x;
+                        continue;
+                    }
+
+                    const int rangeStart = x;
+                    while (x < CHUNK_SIZE && bits.test(x + y * CHUNK_SIZE))
+                        ++x;
+
+                    const QRect range(chunkPos.x() * CHUNK_SIZE + rangeStart + mX,
+                                      chunkY * CHUNK_SIZE + y + mY,
+                                      x - rangeStart, 1);
+
+                    // Join ranges that continue into the next chunk
+                    if (rects.size() > bandStart && rects.last().right() + 1 == range.left())
+                        rects.last().setRight(range.right());
+                    else
+                        rects.append(range);
+                }
+            }
+        }
+    }
+
+    QRegion region;
+    region.setRects(rects.constData(), rects.size());
+    return region;
+}
+
+const QHash<Cell, TileLayer::CellOccurrences> &TileLayer::cellOccurrences() const
+{
+    if (mCellOccurrencesDirty) {
+        QHash<Cell, CellOccurrences> cellOccurrences;
+
+        for (auto it = mChunks.begin(), it_end = mChunks.end(); it != it_end; ++it) {
+            const Chunk &chunk = it.value();
+            int index = 0;
+
+            for (const Cell &cell : chunk) {
+                if (!cell.isEmpty())
+                    cellOccurrences[cell][it.key()].set(index);
+                ++index;
+            }
+        }
+
+        mCellOccurrences.swap(cellOccurrences);
+        mCellOccurrencesDirty = false;
+    }
+
+    return mCellOccurrences;
+}
+
 /**
  * Sets the cell at the given coordinates.
  */
@@ -197,9 +414,105 @@ void Tiled::TileLayer::setCell(int x, int y, const Cell &cell)
         }
     }
 
+    if (!mCellOccurrencesDirty) {
+        const Cell &oldCell = _chunk.cellAt(x & CHUNK_MASK, y & CHUNK_MASK);
+        if (oldCell != cell) {
+            const QPoint chunkPos = chunkCoordinates(x, y);
+            const int index = (x & CHUNK_MASK) + (y & CHUNK_MASK) * CHUNK_SIZE;
+
+            if (!oldCell.isEmpty()) {
+                auto it = mCellOccurrences.find(oldCell);
+                if (it != mCellOccurrences.end()) {
+                    auto chunkIt = it->find(chunkPos);
+                    if (chunkIt != it->end()) {
+                        chunkIt->reset(index);
+                        if (chunkIt->none())
+                            it->erase(chunkIt);
+                    }
+                    if (it->isEmpty())
+                        mCellOccurrences.erase(it);
+                }
+            }
+
+            if (!cell.isEmpty())
+                mCellOccurrences[cell][chunkPos].set(index);
+        }
+    }
+
     _chunk.setCell(x & CHUNK_MASK, y & CHUNK_MASK, cell);
 }
 
+template<typename T>
+void TileLayer::setCellsFromGridImpl(QRect area, const T *values, const QVector<Cell> &cells)
+{
+    auto cellForValue = [&] (T value) -> const Cell & {
+        return value < cells.size() ? cells.at(value) : Cell::empty;
+    };
+
+    auto valuesAt = [&] (int x, int y) {
+        return values + (y - area.top()) * area.width() + (x - area.left());
+    };
+
+    for (int startY = area.top(); startY <= area.bottom(); startY = (startY | CHUNK_MASK) + 1) {
+        const int endY = std::min(area.bottom(), startY | CHUNK_MASK);
+
+        for (int startX = area.left(); startX <= area.right(); startX = (startX | CHUNK_MASK) + 1) {
+            const int endX = std::min(area.right(), startX | CHUNK_MASK);
+            const QPoint chunkPos = chunkCoordinates(startX, startY);
+
+            auto it = mChunks.find(chunkPos);
+            if (it == mChunks.end()) {
+                // Only allocate the chunk when it will contain any tiles
+                bool hasTiles = false;
+                for (int y = startY; y <= endY && !hasTiles; ++y) {
+                    const T *row = valuesAt(startX, y);
+                    for (int x = startX; x <= endX && !hasTiles; ++x)
+                        hasTiles = !cellForValue(*row++).isEmpty();
+                }
+
+                if (!hasTiles)
+                    continue;
+
+                it = mChunks.insert(chunkPos, Chunk());
+                mBounds = mBounds.united(QRect(chunkPos * CHUNK_SIZE,
+                                               QSize(CHUNK_SIZE, CHUNK_SIZE)));
+            }
+
+            Chunk &chunk = it.value();
+            for (int y = startY; y <= endY; ++y) {
+                const T *row = valuesAt(startX, y);
+                for (int x = startX; x <= endX; ++x)
+                    chunk.setCell(x & CHUNK_MASK, y & CHUNK_MASK, cellForValue(*row++));
+            }
+        }
+    }
+
+    mUsedTilesetsDirty = true;
+    invalidateCellOccurrences();
+}
+
+/**
+ * Sets the cells within the given \a area from a dense grid of \a values,
+ * stored row by row. Each value is used as index into \a cells, with values
+ * out of its range resulting in empty cells.
+ *
+ * This is meant for importing simple grid based formats. The chunks are
+ * filled directly, which is much faster than calling setCell() for each
+ * cell.
+ */
+void TileLayer::setCellsFromGrid(QRect area, const quint8 *values, const QVector<Cell> &cells)
+{
+    setCellsFromGridImpl(area, values, cells);
+}
+
+/**
+ * \overload
+ */
+void TileLayer::setCellsFromGrid(QRect area, const quint16 *values, const QVector<Cell> &cells)
+{
+    setCellsFromGridImpl(area, values, cells);
+}
+
 std::unique_ptr<TileLayer> TileLayer::copy(const QRegion &region) const
 {
     const QRect regionBounds = region.boundingRect();
@@ -299,10 +612,12 @@ void TileLayer::erase(const QRegion &region)
  */
 void TileLayer::clear()
 {
-    mChunks.clear();
+    replaceChunks(QHash<QPoint, Chunk>());
     mBounds = QRect();
     mUsedTilesets.clear();
     mUsedTilesetsDirty = false;
+    mCellOccurrences.clear();
+    mCellOccurrencesDirty = false;
 }
 
 void TileLayer::flip(FlipDirection direction)
@@ -335,8 +650,9 @@ void TileLayer::flip(FlipDirection direction)
         }
     }
 
-    mChunks = newLayer->mChunks;
+    replaceChunks(newLayer->mChunks);
     mBounds = newLayer->mBounds;
+    invalidateCellOccurrences();
 }
 
 void TileLayer::flipHexagonal(FlipDirection direction)
@@ -385,8 +701,9 @@ void TileLayer::flipHexagonal(FlipDirection direction)
         }
     }
 
-    mChunks = newLayer->mChunks;
+    replaceChunks(newLayer->mChunks);
     mBounds = newLayer->mBounds;
+    invalidateCellOccurrences();
 }
 
 void TileLayer::rotate(RotateDirection direction)
@@ -435,8 +752,9 @@ void TileLayer::rotate(RotateDirection direction)
 
     mWidth = newWidth;
     mHeight = newHeight;
-    mChunks = newLayer->mChunks;
+    replaceChunks(newLayer->mChunks);
     mBounds = newLayer->mBounds;
+    invalidateCellOccurrences();
 }
 
 void TileLayer::rotateHexagonal(RotateDirection direction, Map *map)
@@ -524,8 +842,9 @@ void TileLayer::rotateHexagonal(RotateDirection direction, Map *map)
 
     mWidth = newWidth;
     mHeight = newHeight;
-    mChunks = newLayer->mChunks;
+    replaceChunks(newLayer->mChunks);
     mBounds = newLayer->mBounds;
+    invalidateCellOccurrences();
 
     QRect filledRect = region().boundingRect();
 
@@ -559,6 +878,29 @@ QSet<SharedTileset> TileLayer::usedTilesets() const
     return mUsedTilesets;
 }
 
+/**
+ * Adds the number of cells referring to each tile to \a usage. Cells
+ * referring to tiles that don't exist are not counted.
+ *
+ * Uses the index of cell occurrences, so that repeated calls only need to
+ * look at the distinct cells on this layer.
+ */
+void TileLayer::countTileUsage(QHash<const Tile *, int> &usage) const
+{
+    const auto &occurrences = cellOccurrences();
+    for (auto it = occurrences.begin(), it_end = occurrences.end(); it != it_end; ++it) {
+        const Tile *tile = it.key().tile();
+        if (!tile)
+            continue;
+
+        int count = 0;
+        for (const ChunkOccurrences &bits : it.value())
+            count += static_cast<int>(bits.count());
+
+        usage[tile] += count;
+    }
+}
+
 bool TileLayer::hasCell(std::function<bool (const Cell &)> condition) const
 {
     for (const Chunk &chunk : mChunks) {
@@ -579,6 +921,8 @@ void TileLayer::removeReferencesToTileset(Tileset *tileset)
     for (Chunk &chunk : mChunks)
         chunk.removeReferencesToTileset(tileset);
 
+    invalidateCellOccurrences();
+
     mUsedTilesets.remove(tileset->sharedPointer());
 }
 
@@ -588,6 +932,8 @@ void TileLayer::replaceReferencesToTileset(Tileset *oldTileset,
     for (Chunk &chunk : mChunks)
         chunk.replaceReferencesToTileset(oldTileset, newTileset);
 
+    invalidateCellOccurrences();
+
     if (mUsedTilesets.remove(oldTileset->sharedPointer()))
         mUsedTilesets.insert(newTileset->sharedPointer());
 }
@@ -605,8 +951,9 @@ void TileLayer::resize(QSize size, QPoint offset)
         for (int x = area.left(); x <= area.right(); ++x)
             newLayer->setCell(x, y, cellAt(x - offset.x(), y - offset.y()));
 
-    mChunks = newLayer->mChunks;
+    replaceChunks(newLayer->mChunks);
     mBounds = newLayer->mBounds;
+    invalidateCellOccurrences();
     setSize(size);
 }
 
@@ -648,8 +995,9 @@ void TileLayer::offsetTiles(QPoint offset,
         }
     }
 
-    mChunks = newLayer->mChunks;
+    replaceChunks(newLayer->mChunks);
     mBounds = newLayer->mBounds;
+    invalidateCellOccurrences();
 }
 
 void TileLayer::offsetTiles(QPoint offset)
@@ -676,8 +1024,9 @@ void TileLayer::offsetTiles(QPoint offset)
         }
     }
 
-    mChunks = newLayer->mChunks;
+    replaceChunks(newLayer->mChunks);
     mBounds = newLayer->mBounds;
+    invalidateCellOccurrences();
 }
 
 bool TileLayer::canMergeWith(const Layer *other) const
@@ -822,6 +1171,77 @@ QVector<QRect> TileLayer::sortedChunksToWrite(QSize chunkSize) const
     return chunksToWrite;
 }
 
+/**
+ * Returns the bounds of the chunks that changed after the given revision,
+ * including the chunks that were removed since. The bounds are in local
+ * tile coordinates, sorted by position.
+ *
+ * Consumers can remember Chunk::currentRevision() after calling this
+ * function and later use it again to process only the chunks changed since.
+ */
+QVector<QRect> TileLayer::changedChunks(quint64 sinceRevision) const
+{
+    QVector<QRect> chunks;
+
+    auto addChunk = [&] (QPoint chunkPos) {
+        chunks.append(QRect(chunkPos * CHUNK_SIZE, QSize(CHUNK_SIZE, CHUNK_SIZE)));
+    };
+
+    for (auto it = mChunks.begin(), it_end = mChunks.end(); it != it_end; ++it)
+        if (it.value().revision() > sinceRevision)
+            addChunk(it.key());
+
+    for (auto it = mRemovedChunks.begin(), it_end = mRemovedChunks.end(); it != it_end; ++it)
+        if (it.value() > sinceRevision && !mChunks.contains(it.key()))
+            addChunk(it.key());
+
+    std::sort(chunks.begin(), chunks.end(), compareRectPos);
+
+    return chunks;
+}
+
+/**
+ * Forgets the chunks removed up to and including the given revision.
+ *
+ * Consumers of changedChunks() should call this once they no longer need
+ * those chunks reported, since the removed chunks are otherwise remembered
+ * for the lifetime of the layer.
+ */
+void TileLayer::discardRemovedChunks(quint64 upToRevision)
+{
+    for (auto it = mRemovedChunks.begin(); it != mRemovedChunks.end(); ) {
+        if (it.value() <= upToRevision)
+            it = mRemovedChunks.erase(it);
+        else
+            ++it;
+    }
+}
+
+/**
+ * Replaces all chunks, remembering the positions of the chunks that were
+ * removed for changedChunks().
+ *
+ * Positions that have a chunk again are forgotten, since the new chunk is
+ * reported as changed already.
+ */
+void TileLayer::replaceChunks(const QHash<QPoint, Chunk> &chunks)
+{
+    quint64 revision = 0;
+
+    for (auto it = mChunks.constBegin(), it_end = mChunks.constEnd(); it != it_end; ++it) {
+        if (!chunks.contains(it.key())) {
+            if (!revision)
+                revision = nextChunkRevision();
+            mRemovedChunks.insert(it.key(), revision);
+        }
+    }
+
+    for (auto it = chunks.constBegin(), it_end = chunks.constEnd(); it != it_end; ++it)
+        mRemovedChunks.remove(it.key());
+
+    mChunks = chunks;
+}
+
 /**
  * Returns a duplicate of this TileLayer.
  *
@@ -836,6 +1256,7 @@ TileLayer *TileLayer::initializeClone(TileLayer *clone) const
 {
     Layer::initializeClone(clone);
     clone->mChunks = mChunks;
+    clone->mRemovedChunks = mRemovedChunks;
     clone->mBounds = mBounds;
     clone->mUsedTilesets = mUsedTilesets;
     clone->mUsedTilesetsDirty = mUsedTilesetsDirty;
@@ -43,6 +43,8 @@
 #include <QString>
 #include <QVector>
 
+#include <algorithm>
+#include <bitset>
 #include <functional>
 
 inline uint qHash(QPoint key, uint seed = 0) Q_DECL_NOTHROW
@@ -165,16 +167,34 @@ inline bool Cell::refersTile(const Tile *tile) const
     return _tileset == tile->tileset() && _tileId == tile->id();
 }
 
+/**
+ * Hashes the tile and the visual flags of the cell, consistent with
+ * Cell::operator==.
+ */
+inline uint qHash(const Cell &cell, uint seed = 0) Q_DECL_NOTHROW
+{
+    const int flags = (cell.flippedHorizontally() << 0) |
+                      (cell.flippedVertically() << 1) |
+                      (cell.flippedAntiDiagonally() << 2) |
+                      (cell.rotatedHexagonal120() << 3);
+
+    return qHash(cell.tileset(), seed) ^ qHash((cell.tileId() << 4) | flags, seed);
+}
+
 
 /**
  * A Chunk is a grid of cells of size CHUNK_SIZExCHUNK_SIZE.
+ *
+ * Each chunk carries the revision at which it was last changed. Revisions
+ * are taken from a single increasing counter, so they can be compared
+ * between chunks and layers. Changing a chunk only marks it as changed, and
+ * it takes its new revision when the revision is asked for. This way a
+ * chunk takes a single revision for all the cells changed in one operation.
  */
 class TILEDSHARED_EXPORT Chunk
 {
 public:
-    Chunk() :
-        mGrid(CHUNK_SIZE * CHUNK_SIZE)
-    {}
+    Chunk();
 
     QRegion region(std::function<bool (const Cell &)> condition) const;
 
@@ -191,15 +211,38 @@ public:
 
     void replaceReferencesToTileset(Tileset *oldTileset, Tileset *newTileset);
 
-    QVector<Cell>::iterator begin() { return mGrid.begin(); }
+    quint64 revision() const;
+
+    quint64 hash() const;
+    bool hasCachedHash() const;
+
+    static quint64 currentRevision();
+
+    // Mutable iteration marks the chunk as changed
+    QVector<Cell>::iterator begin() { touch(); return mGrid.begin(); }
     QVector<Cell>::iterator end() { return mGrid.end(); }
     QVector<Cell>::const_iterator begin() const { return mGrid.begin(); }
     QVector<Cell>::const_iterator end() const { return mGrid.end(); }
 
 private:
+    void touch();
+
     QVector<Cell> mGrid;
+    mutable quint64 mRevision;
+    mutable quint64 mHash;
+    mutable bool mChanged;
+    mutable bool mHashDirty;
 };
 
+/**
+ * Returns whether the hash is cached, in which case hash() is cheap and does
+ * not modify the chunk.
+ */
+inline bool Chunk::hasCachedHash() const
+{
+    return !mHashDirty;
+}
+
 inline const Cell &Chunk::cellAt(int x, int y) const
 {
     return mGrid.at(x + y * CHUNK_SIZE);
@@ -383,12 +426,23 @@ public:
 
     QRegion region(std::function<bool (const Cell &)> condition) const;
     QRegion region() const;
+    QRegion cellRegion(const Cell &cell) const;
 
     const Cell &cellAt(int x, int y) const;
     const Cell &cellAt(QPoint point) const;
 
+    template<typename Function>
+    void forEachCellInRow(int y, int startX, int endX, Function function) const;
+    template<typename Function>
+    void forEachCellInColumn(int x, int startY, int endY, Function function) const;
+    template<typename Function>
+    void forEachNonEmptyCell(Function function) const;
+
     void setCell(int x, int y, const Cell &cell);
 
+    void setCellsFromGrid(QRect area, const quint8 *values, const QVector<Cell> &cells);
+    void setCellsFromGrid(QRect area, const quint16 *values, const QVector<Cell> &cells);
+
     /**
      * Returns a copy of the area specified by the given \a region. The
      * caller is responsible for the returned tile layer.
@@ -460,6 +514,8 @@ public:
      */
     QSet<SharedTileset> usedTilesets() const override;
 
+    void countTileUsage(QHash<const Tile*, int> &usage) const;
+
     /**
      * Returns whether this tile layer has any cell for which the given
      * \a condition returns true.
@@ -523,30 +579,52 @@ public:
 
     TileLayer *clone() const override;
 
-    iterator begin() { return iterator(mChunks.begin(), mChunks.end()); }
+    iterator begin() { invalidateCellOccurrences(); return iterator(mChunks.begin(), mChunks.end()); }
     iterator end() { return iterator(mChunks.end(), mChunks.end()); }
     const_iterator begin() const { return const_iterator(mChunks.begin(), mChunks.end()); }
     const_iterator end() const { return const_iterator(mChunks.end(), mChunks.end()); }
 
     QVector<QRect> sortedChunksToWrite(QSize chunkSize) const;
 
+    QVector<QRect> changedChunks(quint64 sinceRevision) const;
+    void discardRemovedChunks(quint64 upToRevision);
+
 protected:
     TileLayer *initializeClone(TileLayer *clone) const;
 
 private:
+    /**
+     * For each cell of a chunk, whether it contains a certain tile.
+     */
+    using ChunkOccurrences = std::bitset<CHUNK_SIZE * CHUNK_SIZE>;
+    using CellOccurrences = QHash<QPoint, ChunkOccurrences>;
+
+    static QPoint chunkCoordinates(int x, int y);
+
+    template<typename T>
+    void setCellsFromGridImpl(QRect area, const T *values, const QVector<Cell> &cells);
+
+    const QHash<Cell, CellOccurrences> &cellOccurrences() const;
+    void invalidateCellOccurrences();
+
+    void replaceChunks(const QHash<QPoint, Chunk> &chunks);
+
     int mWidth;
     int mHeight;
     QHash<QPoint, Chunk> mChunks;
+    QHash<QPoint, quint64> mRemovedChunks;
     QRect mBounds;
     mutable QSet<SharedTileset> mUsedTilesets;
     mutable bool mUsedTilesetsDirty;
+    mutable QHash<Cell, CellOccurrences> mCellOccurrences;
+    mutable bool mCellOccurrencesDirty;
 };
 
 inline QPoint TileLayer::iterator::key() const
 {
-    QPoint chunkStart = mChunkPointer.key();
+    QPoint chunkStart = mChunkPointer.key() * CHUNK_SIZE;
 
-    int index = mCellPointer - mChunkPointer.value().begin();
+    int index = mCellPointer - static_cast<const Chunk&>(mChunkPointer.value()).begin();
     chunkStart += QPoint(index & CHUNK_MASK, index / CHUNK_SIZE);
 
     return chunkStart;
@@ -565,7 +643,7 @@ inline void TileLayer::iterator::advance()
 
 inline QPoint TileLayer::const_iterator::key() const
 {
-    QPoint chunkStart = mChunkPointer.key();
+    QPoint chunkStart = mChunkPointer.key() * CHUNK_SIZE;
 
     int index = mCellPointer - mChunkPointer.value().begin();
     chunkStart += QPoint(index & CHUNK_MASK, index / CHUNK_SIZE);
@@ -603,18 +681,20 @@ inline bool TileLayer::contains(QPoint point) const
     return contains(point.x(), point.y());
 }
 
+inline QPoint TileLayer::chunkCoordinates(int x, int y)
+{
+    return QPoint(x < 0 ? (x + 1) / CHUNK_SIZE - 1 : x / CHUNK_SIZE,
+                  y < 0 ? (y + 1) / CHUNK_SIZE - 1 : y / CHUNK_SIZE);
+}
+
 inline Chunk& TileLayer::chunk(int x, int y)
 {
-    QPoint chunkCoordinates(x < 0 ? (x + 1) / CHUNK_SIZE - 1 : x / CHUNK_SIZE,
-                            y < 0 ? (y + 1) / CHUNK_SIZE - 1 : y / CHUNK_SIZE);
-    return mChunks[chunkCoordinates];
+    return mChunks[chunkCoordinates(x, y)];
 }
 
 inline const Chunk* TileLayer::findChunk(int x, int y) const
 {
-    QPoint chunkCoordinates(x < 0 ? (x + 1) / CHUNK_SIZE - 1 : x / CHUNK_SIZE,
-                            y < 0 ? (y + 1) / CHUNK_SIZE - 1 : y / CHUNK_SIZE);
-    auto it = mChunks.find(chunkCoordinates);
+    auto it = mChunks.find(chunkCoordinates(x, y));
     return it != mChunks.end() ? &it.value() : nullptr;
 }
 
@@ -644,6 +724,88 @@ inline const Cell &TileLayer::cellAt(QPoint point) const
     return cellAt(point.x(), point.y());
 }
 
+/**
+ * Calls the given \a function for each cell in row \a y, for the columns
+ * in the range [\a startX, \a endX), in order. The function is called with
+ * the x coordinate and a reference to the cell, which is empty outside of
+ * the allocated chunks.
+ *
+ * Each chunk is looked up only once, which makes this much faster than
+ * calling cellAt() for each cell.
+ */
+template<typename Function>
+inline void TileLayer::forEachCellInRow(int y, int startX, int endX, Function function) const
+{
+    int x = startX;
+    while (x < endX) {
+        const int segmentEnd = std::min(endX, (x | CHUNK_MASK) + 1);
+
+        if (const Chunk *chunk = findChunk(x, y)) {
+            const Cell *cell = &chunk->cellAt(x & CHUNK_MASK, y & CHUNK_MASK);
+            for (; x < segmentEnd; ++x, ++cell)
+                function(x, *cell);
+        } else {
+            for (; x < segmentEnd; ++x)
+                function(x, Cell::empty);
+        }
+    }
+}
+
+/**
+ * Calls the given \a function for each cell in column \a x, for the rows in
+ * the range [\a startY, \a endY), in order. The function is called with the
+ * y coordinate and a reference to the cell.
+ *
+ * \sa forEachCellInRow()
+ */
+template<typename Function>
+inline void TileLayer::forEachCellInColumn(int x, int startY, int endY, Function function) const
+{
+    int y = startY;
+    while (y < endY) {
+        const int segmentEnd = std::min(endY, (y | CHUNK_MASK) + 1);
+
+        if (const Chunk *chunk = findChunk(x, y)) {
+            for (; y < segmentEnd; ++y)
+                function(y, chunk->cellAt(x & CHUNK_MASK, y & CHUNK_MASK));
+        } else {
+            for (; y < segmentEnd; ++y)
+                function(y, Cell::empty);
+        }
+    }
+}
+
+/**
+ * Calls the given \a function with the coordinates and a reference to each
+ * non-empty cell of this layer. The cells are visited chunk by chunk, so
+ * their order is unspecified.
+ */
+template<typename Function>
+inline void TileLayer::forEachNonEmptyCell(Function function) const
+{
+    for (auto it = mChunks.begin(), it_end = mChunks.end(); it != it_end; ++it) {
+        const QPoint start = it.key() * CHUNK_SIZE;
+        const Chunk &chunk = it.value();
+
+        for (int y = 0; y < CHUNK_SIZE; ++y) {
+            for (int x = 0; x < CHUNK_SIZE; ++x) {
+                const Cell &cell = chunk.cellAt(x, y);
+                if (!cell.isEmpty())
+                    function(start.x() + x, start.y() + y, cell);
+            }
+        }
+    }
+}
+
+/**
+ * Drops the index of cell occurrences. It will be rebuilt when needed.
+ */
+inline void TileLayer::invalidateCellOccurrences()
+{
+    mCellOccurrences.clear();
+    mCellOccurrencesDirty = true;
+}
+
 inline void TileLayer::setCells(int x, int y, const TileLayer *tileLayer)
 {
     setCells(x, y, tileLayer,
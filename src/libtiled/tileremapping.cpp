@@ -0,0 +1,147 @@
+/*
+ * tileremapping.cpp
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "tileremapping.h"
+
+#include <QVector>
+
+#include <algorithm>
+
+namespace Tiled {
+
+/**
+ * Maps the tile \a from to the tile \a to, regardless of how it is flipped.
+ * When \a to is nullptr, the tile is removed.
+ */
+void TileRemapping::insert(const Tile *from, Tile *to)
+{
+    mTiles.insert(Cell(from->tileset(), from->id()), Cell(to));
+}
+
+/**
+ * Maps cells equal to \a from to \a to. Unlike insert(const Tile*, Tile*),
+ * this only matches the cell with the same flags and also replaces the flags.
+ */
+void TileRemapping::insert(const Cell &from, const Cell &to)
+{
+    Q_ASSERT(!from.isEmpty());
+    mCells.insert(from, to);
+}
+
+/**
+ * Returns the cell the given \a cell maps to, which is the cell itself when
+ * it isn't affected by this remapping.
+ */
+Cell TileRemapping::map(const Cell &cell) const
+{
+    if (cell.isEmpty())
+        return cell;
+
+    auto cellIt = mCells.find(cell);
+    if (cellIt != mCells.end())
+        return cellIt.value();
+
+    auto tileIt = mTiles.find(Cell(cell.tileset(), cell.tileId()));
+    if (tileIt != mTiles.end()) {
+        if (tileIt.value().isEmpty())
+            return Cell();
+
+        Cell mapped = cell;
+        mapped.setTile(tileIt.value().tileset(), tileIt.value().tileId());
+        return mapped;
+    }
+
+    return cell;
+}
+
+/**
+ * Determines the cells of the given \a layer that change when applying this
+ * remapping, in a single pass over its chunks.
+ *
+ * Returns a layer of the same size holding the new cells, and sets
+ * \a changedRegion to the region that changed, in local coordinates.
+ */
+std::unique_ptr<TileLayer> TileRemapping::remapped(const TileLayer &layer,
+                                                   QRegion &changedRegion) const
+{
+    auto changes = std::make_unique<TileLayer>(QString(), 0, 0,
+                                               layer.width(), layer.height());
+    QVector<QRect> rects;
+
+    if (!isEmpty()) {
+        for (auto it = layer.begin(), it_end = layer.end(); it != it_end; ++it) {
+            const Cell &cell = *it;
+            const Cell mappedCell = map(cell);
+            if (mappedCell == cell)
+                continue;
+
+            const QPoint pos = it.key();
+            changes->setCell(pos.x(), pos.y(), mappedCell);
+
+            // Cells are visited row by row within each chunk
+            if (!rects.isEmpty() && rects.last().top() == pos.y() && rects.last().right() + 1 == pos.x())
+                rects.last().setRight(pos.x());
+            else
+                rects.append(QRect(pos, QSize(1, 1)));
+        }
+    }
+
+    // Order the ranges as required by QRegion::setRects, joining the ones
+    // that continue into the next chunk
+    std::sort(rects.begin(), rects.end(), [] (const QRect &a, const QRect &b) {
+        return a.top() < b.top() || (a.top() == b.top() && a.left() < b.left());
+    });
+
+    QVector<QRect> joinedRects;
+    joinedRects.reserve(rects.size());
+    for (const QRect &rect : qAsConst(rects)) {
+        if (!joinedRects.isEmpty() && joinedRects.last().top() == rect.top() && joinedRects.last().right() + 1 == rect.left())
+            joinedRects.last().setRight(rect.right());
+        else
+            joinedRects.append(rect);
+    }
+
+    changedRegion = QRegion();
+    changedRegion.setRects(joinedRects.constData(), joinedRects.size());
+
+    return changes;
+}
+
+/**
+ * Applies this remapping to the given \a layer directly. Returns the region
+ * that changed, in local coordinates.
+ */
+QRegion TileRemapping::apply(TileLayer &layer) const
+{
+    QRegion changedRegion;
+    const auto changes = remapped(layer, changedRegion);
+    layer.setCells(0, 0, changes.get(), changedRegion);
+    return changedRegion;
+}
+
+} // namespace Tiled
@@ -0,0 +1,74 @@
+/*
+ * tileremapping.h
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "tilelayer.h"
+
+#include <QHash>
+#include <QRegion>
+
+#include <memory>
+
+namespace Tiled {
+
+/**
+ * A table that maps tiles to other tiles, used to replace tiles in bulk.
+ *
+ * Tiles can be mapped regardless of how they are flipped, in which case the
+ * flags of the cell are preserved, or mappings can be added for specific
+ * cells, which allows changing the flags as well. Mappings for specific cells
+ * take precedence.
+ *
+ * Empty cells are never mapped.
+ */
+class TILEDSHARED_EXPORT TileRemapping
+{
+public:
+    void insert(const Tile *from, Tile *to);
+    void insert(const Cell &from, const Cell &to);
+
+    bool isEmpty() const;
+
+    Cell map(const Cell &cell) const;
+
+    std::unique_ptr<TileLayer> remapped(const TileLayer &layer,
+                                        QRegion &changedRegion) const;
+    QRegion apply(TileLayer &layer) const;
+
+private:
+    QHash<Cell, Cell> mTiles;
+    QHash<Cell, Cell> mCells;
+};
+
+inline bool TileRemapping::isEmpty() const
+{
+    return mTiles.isEmpty() && mCells.isEmpty();
+}
+
+} // namespace Tiled
@@ -72,9 +72,10 @@ SharedTileset readTileset(const QString &fileName, QString *error)
 
 TilesetFormat *findSupportingTilesetFormat(const QString &fileName)
 {
+    const QByteArray header = FileFormat::readFileHeader(fileName);
     const auto tilesetFormats = PluginManager::objects<TilesetFormat>();
     for (TilesetFormat *format : tilesetFormats)
-        if (format->supportsFile(fileName))
+        if (format->supportsFileHeader(fileName, header))
             return format;
     return nullptr;
 }
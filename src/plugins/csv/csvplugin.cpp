@@ -22,11 +22,9 @@
 
 #include "grouplayer.h"
 #include "map.h"
-#include "savefile.h"
 #include "tile.h"
 #include "tilelayer.h"
 
-#include <QCoreApplication>
 #include <QDir>
 #include <QFileInfo>
 
@@ -44,55 +42,45 @@ bool CsvPlugin::write(const Map *map, const QString &fileName, Options options)
     // Get file paths for each layer
     QStringList layerPaths = outputFiles(map, fileName);
 
-    // Traverse all tile layers
+    // Each tile layer is written to a separate file, so they can be written
+    // in parallel
+    QVector<OutputFile> files;
+
     int currentLayer = 0;
     for (const Layer *layer : map->tileLayers()) {
         const TileLayer *tileLayer = static_cast<const TileLayer*>(layer);
 
-        SaveFile file(layerPaths.at(currentLayer));
-
-        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-            mError = QCoreApplication::translate("File Errors", "Could not open file for writing.");
-            return false;
-        }
-
-        auto device = file.device();
-
         QRect bounds = map->infinite() ? tileLayer->bounds() : tileLayer->rect();
         bounds.translate(-layer->position());
 
-        // Write out tiles either by ID or their name, if given. -1 is "empty"
-        for (int y = bounds.top(); y <= bounds.bottom(); ++y) {
-            for (int x = bounds.left(); x <= bounds.right(); ++x) {
-                if (x > bounds.left())
-                    device->write(",", 1);
-
-                const Cell &cell = tileLayer->cellAt(x, y);
-                const Tile *tile = cell.tile();
-                if (tile && tile->hasProperty(QLatin1String("name"))) {
-                    device->write(tile->property(QLatin1String("name")).toString().toUtf8());
-                } else {
-                    const int id = tile ? tile->id() : -1;
-                    device->write(QByteArray::number(id));
-                }
+        OutputFile file;
+        file.fileName = layerPaths.at(currentLayer);
+        file.write = [tileLayer, bounds] (QIODevice *device, QString &) {
+            // Write out tiles either by ID or their name, if given. -1 is "empty"
+            for (int y = bounds.top(); y <= bounds.bottom(); ++y) {
+                tileLayer->forEachCellInRow(y, bounds.left(), bounds.right() + 1, [&] (int x, const Cell &cell) {
+                    if (x > bounds.left())
+                        device->write(",", 1);
+
+                    const Tile *tile = cell.tile();
+                    if (tile && tile->hasProperty(QLatin1String("name"))) {
+                        device->write(tile->property(QLatin1String("name")).toString().toUtf8());
+                    } else {
+                        const int id = tile ? tile->id() : -1;
+                        device->write(QByteArray::number(id));
+                    }
+                });
+
+                device->write("\n", 1);
             }
-
-            device->write("\n", 1);
-        }
-
-        if (file.error() != QFileDevice::NoError) {
-            mError = file.errorString();
-            return false;
-        }
-
-        if (!file.commit()) {
-            mError = file.errorString();
-            return false;
-        }
+            return true;
+        };
+        files.append(file);
 
         ++currentLayer;
     }
-    return true;
+
+    return writeFiles(files, mError);
 }
 
 QString CsvPlugin::errorString() const
@@ -32,42 +32,33 @@
 #include <QCoreApplication>
 #include <QTextStream>
 
-#include <cmath>
-
 namespace Defold {
 
-static const char cell_t[] =
-"  cell {\n\
-    x: {{x}}\n\
-    y: {{y}}\n\
-    tile: {{tile}}\n\
-    h_flip: {{h_flip}}\n\
-    v_flip: {{v_flip}}\n\
-  }\n";
-
-static const char layer_t[] =
-"layers {\n\
-  id: \"{{id}}\"\n\
-  z: {{z}}\n\
-  is_visible: {{is_visible}}\n\
-{{cells}}\
-}\n";
-
-static const char map_t[] =
-"tile_set: \"{{tile_set}}\"\n\
-{{layers}}\n\
-material: \"{{material}}\"\n\
-blend_mode: {{blend_mode}}\n";
-
-static QString replaceTags(QString context, const QVariantHash &map)
+static void writeLayer(QTextStream &stream, const Tiled::TileLayer &tileLayer)
 {
-    QHashIterator<QString,QVariant> it{map};
-    while (it.hasNext()) {
-        it.next();
-        context.replace(QLatin1String("{{") + it.key() + QLatin1String("}}"),
-                        it.value().toString());
+    stream << "layers {\n"
+              "  id: \"" << tileLayer.name() << "\"\n"
+              "  z: 0\n"
+              "  is_visible: " << (tileLayer.isVisible() ? 1 : 0) << "\n";
+
+    const int height = tileLayer.height();
+
+    for (int x = 0; x < tileLayer.width(); ++x) {
+        tileLayer.forEachCellInColumn(x, 0, height, [&] (int y, const Tiled::Cell &cell) {
+            if (cell.isEmpty())
+                return;
+
+            stream << "  cell {\n"
+                      "    x: " << x << "\n"
+                      "    y: " << (height - y - 1) << "\n"
+                      "    tile: " << cell.tileId() << "\n"
+                      "    h_flip: " << (cell.flippedHorizontally() ? 1 : 0) << "\n"
+                      "    v_flip: " << (cell.flippedVertically() ? 1 : 0) << "\n"
+                      "  }\n";
+        });
     }
-    return context;
+
+    stream << "}\n";
 }
 
 DefoldPlugin::DefoldPlugin()
@@ -93,47 +84,25 @@ bool DefoldPlugin::write(const Tiled::Map *map, const QString &fileName, Options
 {
     Q_UNUSED(options)
 
-    QVariantHash map_h;
-
-    QString layers;
-    Tiled::LayerIterator it(map, Tiled::Layer::TileLayerType);
-    while (auto tileLayer = static_cast<Tiled::TileLayer*>(it.next())) {
-        QVariantHash layer_h;
-        layer_h["id"] = tileLayer->name();
-        layer_h["z"] = 0;
-        layer_h["is_visible"] = tileLayer->isVisible() ? 1 : 0;
-        QString cells;
-
-        for (int x = 0; x < tileLayer->width(); ++x) {
-            for (int y = 0; y < tileLayer->height(); ++y) {
-                const Tiled::Cell &cell = tileLayer->cellAt(x, y);
-                if (cell.isEmpty())
-                    continue;
-                QVariantHash cell_h;
-                cell_h["x"] = x;
-                cell_h["y"] = tileLayer->height() - y - 1;
-                cell_h["tile"] = cell.tileId();
-                cell_h["h_flip"] = cell.flippedHorizontally() ? 1 : 0;
-                cell_h["v_flip"] = cell.flippedVertically() ? 1 : 0;
-                cells.append(replaceTags(QLatin1String(cell_t), cell_h));
-            }
-        }
-        layer_h["cells"] = cells;
-        layers.append(replaceTags(QLatin1String(layer_t), layer_h));
-    }
-    map_h["layers"] = layers;
-    map_h["material"] = "/builtins/materials/tile_map.material";
-    map_h["blend_mode"] = "BLEND_MODE_ALPHA";
-    map_h["tile_set"] = "";
-
-    QString result = replaceTags(QLatin1String(map_t), map_h);
     Tiled::SaveFile mapFile(fileName);
     if (!mapFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
         mError = QCoreApplication::translate("File Errors", "Could not open file for writing.");
         return false;
     }
+
+    // The cells are streamed straight to the file, since building the
+    // output in memory gets slow for large maps
     QTextStream stream(mapFile.device());
-    stream << result;
+    stream << "tile_set: \"\"\n";
+
+    Tiled::LayerIterator it(map, Tiled::Layer::TileLayerType);
+    while (auto tileLayer = static_cast<Tiled::TileLayer*>(it.next()))
+        writeLayer(stream, *tileLayer);
+
+    stream << "\n"
+              "material: \"/builtins/materials/tile_map.material\"\n"
+              "blend_mode: BLEND_MODE_ALPHA\n";
+    stream.flush();
 
     if (mapFile.error() != QFileDevice::NoError) {
         mError = mapFile.errorString();
@@ -33,37 +33,12 @@
 #include <QCoreApplication>
 #include <QDir>
 #include <QFileInfo>
+#include <QSet>
 #include <QTextStream>
-
 #include <cmath>
 
 namespace DefoldCollection {
 
-static const char cellTemplate[] =
-R"(  cell {
-    x: {{x}}
-    y: {{y}}
-    tile: {{tile}}
-    h_flip: {{h_flip}}
-    v_flip: {{v_flip}}
-  }
-)";
-
-static const char layerTemplate[] =
-R"(layers {
-  id: "{{id}}"
-  z: {{z}}
-  is_visible: {{is_visible}}
-{{cells}}}
-)";
-
-static const char tileMapTemplate[] =
-R"(tile_set: "{{tile_set}}"
-{{layers}}
-material: "{{material}}"
-blend_mode: {{blend_mode}}
-)";
-
 static const char collectionTemplate[] =
 R"(name: "default"
 scale_along_z: 0
@@ -128,6 +103,90 @@ static QString replaceTags(QString context, const QVariantHash &map)
     return context;
 }
 
+/**
+ * The cells of a tile layer in .tilemap format, separately for each tileset.
+ */
+using CellsByTileset = QHash<const Tiled::Tileset*, QString>;
+
+/**
+ * Writes the cells of \a tileLayer column by column, in a single pass over
+ * the layer.
+ */
+static CellsByTileset cellsByTileset(const Tiled::TileLayer &tileLayer)
+{
+    CellsByTileset cellsByTileset;
+
+    const int height = tileLayer.height();
+
+    for (int x = 0; x < tileLayer.width(); ++x) {
+        tileLayer.forEachCellInColumn(x, 0, height, [&] (int y, const Tiled::Cell &cell) {
+            if (cell.isEmpty())
+                return;
+
+            QString &cells = cellsByTileset[cell.tileset()];
+            cells += QLatin1String("  cell {\n    x: ");
+            cells += QString::number(x);
+            cells += QLatin1String("\n    y: ");
+            cells += QString::number(height - y - 1);
+            cells += QLatin1String("\n    tile: ");
+            cells += QString::number(cell.tileId());
+            cells += QLatin1String("\n    h_flip: ");
+            cells += QLatin1Char(cell.flippedHorizontally() ? '1' : '0');
+            cells += QLatin1String("\n    v_flip: ");
+            cells += QLatin1Char(cell.flippedVertically() ? '1' : '0');
+            cells += QLatin1String("\n  }\n");
+        });
+    }
+
+    return cellsByTileset;
+}
+
+static void appendLayer(QString &layers,
+                        const QString &id,
+                        float z,
+                        bool visible,
+                        const QString &cells)
+{
+    layers += QLatin1String("layers {\n  id: \"");
+    layers += id;
+    layers += QLatin1String("\"\n  z: ");
+    layers += QVariant(z).toString();
+    layers += QLatin1String("\n  is_visible: ");
+    layers += QLatin1Char(visible ? '1' : '0');
+    layers += QLatin1Char('\n');
+    layers += cells;
+    layers += QLatin1String("}\n");
+}
+
+static void writeTileMap(QIODevice *device,
+                         const Tiled::Tileset &tileset,
+                         const QString &layers)
+{
+    // Below, we input a value that's not necessarily correct in Defold, but it lets the user know what tilesource to link this tilemap with manually.
+    // However, if the user keeps all tilesources in /tilesources/ and the name of the tilesource corresponds with the name of the tileset in Defold,
+    // the value will be automatically correct.
+    QTextStream stream(device);
+    stream << "tile_set: \"/tilesources/" << tileset.name() << ".tilesource\"\n"
+           << layers
+           << "\n"
+              "material: \"/builtins/materials/tile_map.material\"\n"
+              "blend_mode: BLEND_MODE_ALPHA\n";
+    stream.flush();
+}
+
+static Tiled::MapFormat::OutputFile tileMapFile(const QString &filePath,
+                                                const Tiled::SharedTileset &tileset,
+                                                const QString &layers)
+{
+    Tiled::MapFormat::OutputFile file;
+    file.fileName = filePath;
+    file.write = [tileset, layers] (QIODevice *device, QString &) {
+        writeTileMap(device, *tileset, layers);
+        return true;
+    };
+    return file;
+}
+
 DefoldCollectionPlugin::DefoldCollectionPlugin()
 {
 }
@@ -222,93 +281,52 @@ bool DefoldCollectionPlugin::write(const Tiled::Map *map, const QString &collect
     QString tilesetFileDir = outputFilePath;
     tilesetFileDir.chop(outputFileName.length());
 
+    // the .tilemap files are independent, so they are written in parallel
+    QVector<OutputFile> tileMapFiles;
+
     // dealing with top-level tile layers here only
+    // the cells of each layer are collected once, separately for each tileset
+    QVector<const Tiled::TileLayer*> topLevelTileLayers;
+    QVector<CellsByTileset> topLevelCells;
+    for (auto layer : map->layers()) {
+        if (layer->layerType() != Tiled::Layer::TileLayerType)
+            continue;
+        auto tileLayer = static_cast<Tiled::TileLayer*>(layer);
+        topLevelTileLayers.append(tileLayer);
+        topLevelCells.append(cellsByTileset(*tileLayer));
+    }
+
     // create a tilemap file for each tileset this map uses, and for each of them create a "component" in the main embedded instance
     for (auto &tileset : map->tilesets()) {
         QString tilemapFilePath = tilesetFileDir;
         tilemapFilePath.append(mapName + "-" + tileset->name() + ".tilemap");
 
-        QVariantHash componentHash;
-        componentHash["tilemap_name"] = mapName + "-" + tileset->name();
-        componentHash["tilemap_rel_path"] = tilesetRelativePath(tilemapFilePath);
-
-        QVariantHash tileMapHash;
-
-        bool tilemapHasCells = false;
-
-        int componentCells = 0;
         QString layers;
-        for (auto layer : map->layers()) {
-            if (layer->layerType() != Tiled::Layer::TileLayerType)
-                continue;
-            auto tileLayer = static_cast<Tiled::TileLayer*>(layer);
-
-            QVariantHash layerHash;
-            layerHash["id"] = tileLayer->name();
-            layerHash["z"] = zIndexForLayer(*map, *tileLayer, true);
-            layerHash["is_visible"] = tileLayer->isVisible() ? 1 : 0;
-            QString cells;
-
-            for (int x = 0; x < tileLayer->width(); ++x) {
-                for (int y = 0; y < tileLayer->height(); ++y) {
-                    const Tiled::Cell &cell = tileLayer->cellAt(x, y);
-                    if (cell.isEmpty())
-                        continue;
-                    if (cell.tileset() != tileset) // skip cell if it doesn't belong to current tileset
-                        continue;
-
-                    tilemapHasCells = true;
-                    componentCells++;
-                    QVariantHash cellHash;
-                    cellHash["x"] = x;
-                    cellHash["y"] = tileLayer->height() - y - 1;
-                    cellHash["tile"] = cell.tileId();
-                    cellHash["h_flip"] = cell.flippedHorizontally() ? 1 : 0;
-                    cellHash["v_flip"] = cell.flippedVertically() ? 1 : 0;
-                    cells.append(replaceTags(QLatin1String(cellTemplate), cellHash));
-
-                    // Create a component for this embedded instance only when the first cell of this component is found.
-                    // If 0 cells are found, this component is not necessary.
-                    // If more than 1 cells are found, recreating it would be redundant.
-                    if (componentCells == 1)
-                        topLevelComponents.append(replaceTags(QLatin1String(componentTemplate), componentHash));
-                }
-            }
-            layerHash["cells"] = cells;
+        for (int i = 0; i < topLevelTileLayers.size(); ++i) {
+            const QString cells = topLevelCells.at(i).value(tileset.data());
 
             // only add this layer to the .tilemap if it has any cells
-            if (!cells.isEmpty())
-                layers.append(replaceTags(QLatin1String(layerTemplate), layerHash));
+            if (cells.isEmpty())
+                continue;
+
+            const Tiled::TileLayer *tileLayer = topLevelTileLayers.at(i);
+            appendLayer(layers,
+                        tileLayer->name(),
+                        zIndexForLayer(*map, *tileLayer, true),
+                        tileLayer->isVisible(),
+                        cells);
         }
-        // make a check that this tilemap has cells at all, or no .tilesource file is necessary
-        if (tilemapHasCells) {
-            tileMapHash["layers"] = layers;
-            tileMapHash["material"] = "/builtins/materials/tile_map.material";
-            tileMapHash["blend_mode"] = "BLEND_MODE_ALPHA";
-            // Below, we input a value that's not necessarily correct in Defold, but it lets the user know what tilesource to link this tilemap with manually.
-            // However, if the user keeps all tilesources in /tilesources/ and the name of the tilesource corresponds with the name of the tileset in Defold,
-            // the value will be automatically correct.
-            tileMapHash["tile_set"] = "/tilesources/" + tileset->name() + ".tilesource";
-
-            QString result = replaceTags(QLatin1String(tileMapTemplate), tileMapHash);
-            Tiled::SaveFile mapFile(tilemapFilePath);
-            if (!mapFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
-                mError = QCoreApplication::translate("File Errors", "Could not open file for writing.");
-                return false;
-            }
-            QTextStream stream(mapFile.device());
-            stream << result;
 
-            if (mapFile.error() != QFileDevice::NoError) {
-                mError = mapFile.errorString();
-                return false;
-            }
+        // make a check that this tilemap has cells at all, or no .tilemap file is necessary
+        if (layers.isEmpty())
+            continue;
 
-            if (!mapFile.commit()) {
-                mError = mapFile.errorString();
-                return false;
-            }
-        }
+        QVariantHash componentHash;
+        componentHash["tilemap_name"] = mapName + "-" + tileset->name();
+        componentHash["tilemap_rel_path"] = tilesetRelativePath(tilemapFilePath);
+        topLevelComponents.append(replaceTags(QLatin1String(componentTemplate), componentHash));
+
+        tileMapFiles.append(tileMapFile(tilemapFilePath, tileset, layers));
     }
 
     // For each Group Layer, create a "GameObject" parented to the "tilemaps" GO
@@ -330,91 +348,45 @@ bool DefoldCollectionPlugin::write(const Tiled::Map *map, const QString &collect
 
         QString components;
 
+        // collect the cells of the child tile layers once, rather than for each tileset
+        QVector<const Tiled::TileLayer*> tileLayers;
+        QVector<CellsByTileset> tileLayerCells;
+        for (auto subLayer : groupLayer->layers()) {
+            if (auto tileLayer = subLayer->asTileLayer()) {
+                tileLayers.append(tileLayer);
+                tileLayerCells.append(cellsByTileset(*tileLayer));
+            }
+        }
+
         // write as many tilemaps as there are tilesets per group layer
         for (auto &tileset : map->tilesets()) {
             QString tilemapFilePath = tilesetFileDir;
             tilemapFilePath.append(mapName + "-" + layer->name() + "-" + tileset->name() + ".tilemap");
 
-            QVariantHash tileMapHash;
             QString layers;
-
-            int componentCells = 0;
-            for (auto subLayer : groupLayer->layers()) {
-                auto tileLayer = subLayer->asTileLayer();
-                if (!tileLayer)
+            for (int i = 0; i < tileLayers.size(); ++i) {
+                const QString cells = tileLayerCells.at(i).value(tileset.data());
+                if (cells.isEmpty())
                     continue;
 
-                QVariantHash layerHash;
-                layerHash["id"] = tileLayer->name();
-                layerHash["z"] = zIndexForLayer(*map, *subLayer, false);
-
-                layerHash["is_visible"] = layer->isVisible() ? 1 : 0;
-                QString cells;
-
-                for (int x = 0; x < tileLayer->width(); ++x) {
-                    for (int y = 0; y < tileLayer->height(); ++y) {
-                        const Tiled::Cell &cell = tileLayer->cellAt(x, y);
-                        if (cell.isEmpty() || cell.tileset() != tileset) // skip cell if it doesn't belong to current tileset
-                            continue;
-
-                        QVariantHash cellHash;
-                        cellHash["x"] = x;
-                        cellHash["y"] = tileLayer->height() - y - 1;
-                        cellHash["tile"] = cell.tileId();
-                        cellHash["h_flip"] = cell.flippedHorizontally() ? 1 : 0;
-                        cellHash["v_flip"] = cell.flippedVertically() ? 1 : 0;
-                        cells.append(replaceTags(QLatin1String(cellTemplate), cellHash));
-                        componentCells++;
-
-                        // Create a component for this embedded instance only when the first cell of this component is found.
-                        // If 0 cells are found, this component is not necessary.
-                        // If more than 1 cells are found, recreating it would be redundant.
-                        if (componentCells == 1) {
-                            QVariantHash componentHash;
-                            componentHash["tilemap_name"] = mapName + "-" + layer->name() + "-" + tileset->name();
-                            componentHash["tilemap_rel_path"] = tilesetRelativePath(tilemapFilePath);
-                            components.append(replaceTags(QLatin1String(componentTemplate), componentHash));
-                        }
-                    }
-                }
-
-                if (!cells.isEmpty()) {
-                    layerHash["cells"] = cells;
-                    layers.append(replaceTags(QLatin1String(layerTemplate), layerHash));
-                }
+                const Tiled::TileLayer *tileLayer = tileLayers.at(i);
+                appendLayer(layers,
+                            tileLayer->name(),
+                            zIndexForLayer(*map, *tileLayer, false),
+                            layer->isVisible(),
+                            cells);
             }
 
             // no need to save a tilemap with 0 cells
             if (layers.isEmpty())
                 continue;
 
-            tileMapHash["layers"] = layers;
-            tileMapHash["material"] = "/builtins/materials/tile_map.material";
-            tileMapHash["blend_mode"] = "BLEND_MODE_ALPHA";
-            // Below, we input a value that's not necessarily correct in Defold, but it lets the user know what tilesource to link this tilemap with manually.
-            // However, if the user keeps all tilesources in /tilesources/ and the name of the tilesource corresponds with the name of the tileset in Defold,
-            // the value will be automatically correct.
-            tileMapHash["tile_set"] = "/tilesources/" + tileset->name() + ".tilesource";
-
-            QString result = replaceTags(QLatin1String(tileMapTemplate), tileMapHash);
-            Tiled::SaveFile mapFile(tilemapFilePath);
-            if (!mapFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
-                mError = QCoreApplication::translate("File Errors", "Could not open file for writing.");
-                return false;
-            }
-
-            QTextStream stream(mapFile.device());
-            stream << result;
+            QVariantHash componentHash;
+            componentHash["tilemap_name"] = mapName + "-" + layer->name() + "-" + tileset->name();
+            componentHash["tilemap_rel_path"] = tilesetRelativePath(tilemapFilePath);
+            components.append(replaceTags(QLatin1String(componentTemplate), componentHash));
 
-            if (mapFile.error() != QFileDevice::NoError) {
-                mError = mapFile.errorString();
-                return false;
-            }
-
-            if (!mapFile.commit()) {
-                mError = mapFile.errorString();
-                return false;
-            }
+            tileMapFiles.append(tileMapFile(tilemapFilePath, tileset, layers));
         }
         emdeddedInstanceHash["components"] = components;
         embeddedInstances.append(replaceTags(QLatin1String(emdeddedInstanceTemplate), emdeddedInstanceHash));
@@ -425,6 +397,21 @@ bool DefoldCollectionPlugin::write(const Tiled::Map *map, const QString &collect
     embeddedInstances.prepend(replaceTags(QLatin1String(emdeddedInstanceTemplate), mainEmbeddedInstanceHash));
     collectionHash["embedded-instances"] = embeddedInstances;
 
+    // the tilemap files are written in parallel, so their names need to be unique
+    QSet<QString> tileMapFileNames;
+    for (const OutputFile &file : qAsConst(tileMapFiles)) {
+        if (tileMapFileNames.contains(file.fileName)) {
+            mError = tr("More than one tilemap would be written to %1. "
+                        "Please make sure the names of the tilesets and group layers don't conflict.")
+                    .arg(QDir::toNativeSeparators(file.fileName));
+            return false;
+        }
+        tileMapFileNames.insert(file.fileName);
+    }
+
+    if (!writeFiles(tileMapFiles, mError))
+        return false;
+
     QString result = replaceTags(QLatin1String(collectionTemplate), collectionHash);
     Tiled::SaveFile mapFile(collectionFile);
     if (!mapFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
@@ -70,15 +70,13 @@ std::unique_ptr<Tiled::Map> DroidcraftPlugin::read(const QString &fileName)
     auto mapLayer = std::make_unique<TileLayer>("map", 0, 0, 48, 48);
 
     // Load
-    for (int i = 0; i < 48 * 48; i++) {
-        unsigned char tileId = uncompressed.at(i);
+    QVector<Cell> cells(256);
+    for (int tileId = 0; tileId < cells.size(); ++tileId)
+        cells[tileId] = Cell(mapTileset->findTile(tileId));
 
-        int y = i / 48;
-        int x = i - (48 * y);
-
-        Tile *tile = mapTileset->findTile(tileId);
-        mapLayer->setCell(x, y, Cell(tile));
-    }
+    mapLayer->setCellsFromGrid(QRect(0, 0, 48, 48),
+                               reinterpret_cast<const quint8*>(uncompressed.constData()),
+                               cells);
 
     map->addLayer(std::move(mapLayer));
 
@@ -117,10 +115,10 @@ bool DroidcraftPlugin::write(const Tiled::Map *map, const QString &fileName, Opt
     const int height = mapLayer->height();
 
     for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            if (Tile *tile = mapLayer->cellAt(x, y).tile())
+        mapLayer->forEachCellInRow(y, 0, width, [&] (int x, const Cell &cell) {
+            if (Tile *tile = cell.tile())
                 uncompressed[y * width + x] = (unsigned char) tile->id();
-        }
+        });
     }
 
     QByteArray compressed = compress(uncompressed, Gzip);
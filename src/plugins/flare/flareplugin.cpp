@@ -35,15 +35,144 @@
 #include <QCoreApplication>
 #include <QDir>
 #include <QFileInfo>
-#include <QStringList>
 #include <QTextStream>
 
+#include <cstring>
+#include <limits>
 #include <memory>
 
 using namespace Tiled;
 
 namespace Flare {
 
+namespace {
+
+/**
+ * Splits a buffer into lines without copying, like QTextStream::readLine
+ * but much faster for large files.
+ */
+class LineReader
+{
+public:
+    LineReader(const char *data, qint64 size)
+        : mPos(data)
+        , mEnd(data + size)
+    {
+        // Skip the UTF-8 byte order mark, like QTextStream does
+        if (size >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0)
+            mPos += 3;
+    }
+
+    bool atEnd() const { return mPos == mEnd; }
+
+    /**
+     * Reads the next line into the range [\a begin, \a end), excluding the
+     * line ending. Returns false when there are no more lines.
+     */
+    bool readLine(const char *&begin, const char *&end)
+    {
+        if (atEnd())
+            return false;
+
+        begin = mPos;
+        end = static_cast<const char*>(memchr(mPos, '\n', static_cast<size_t>(mEnd - mPos)));
+        if (end) {
+            mPos = end + 1;
+        } else {
+            end = mEnd;
+            mPos = mEnd;
+        }
+
+        if (end != begin && end[-1] == '\r')
+            --end;
+
+        return true;
+    }
+
+    QString readLine()
+    {
+        const char *begin;
+        const char *end;
+        if (!readLine(begin, end))
+            return QString();
+        return QString::fromUtf8(begin, static_cast<int>(end - begin));
+    }
+
+private:
+    const char *mPos;
+    const char * const mEnd;
+};
+
+/**
+ * Parses the integer in the range [\a begin, \a end), ignoring surrounding
+ * whitespace. Returns 0 when the range does not contain a valid integer,
+ * like QString::toInt.
+ */
+int parseInt(const char *begin, const char *end, int base)
+{
+    while (begin != end && (*begin == ' ' || *begin == '\t'))
+        ++begin;
+    while (end != begin && (end[-1] == ' ' || end[-1] == '\t'))
+        --end;
+
+    bool negative = false;
+    if (begin != end && (*begin == '-' || *begin == '+')) {
+        negative = *begin == '-';
+        ++begin;
+    }
+
+    if (base == 16 && end - begin > 2 && begin[0] == '0' && (begin[1] == 'x' || begin[1] == 'X'))
+        begin += 2;
+
+    if (begin == end)
+        return 0;
+
+    qint64 value = 0;
+    for (; begin != end; ++begin) {
+        int digit;
+        const char c = *begin;
+        if (c >= '0' && c <= '9')
+            digit = c - '0';
+        else if (c >= 'a' && c <= 'z')
+            digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'Z')
+            digit = c - 'A' + 10;
+        else
+            return 0;
+
+        if (digit >= base)
+            return 0;
+
+        value = value * base + digit;
+        if (value > std::numeric_limits<int>::max() + qint64(negative))
+            return 0;
+    }
+
+    return static_cast<int>(negative ? -value : value);
+}
+
+/**
+ * Appends the decimal representation of \a value to \a out.
+ */
+void appendNumber(QByteArray &out, int value)
+{
+    char digits[11];
+    int length = 0;
+    unsigned absolute = value < 0 ? 0u - static_cast<unsigned>(value)
+                                  : static_cast<unsigned>(value);
+    do {
+        digits[length++] = static_cast<char>('0' + absolute % 10);
+        absolute /= 10;
+    } while (absolute);
+
+    if (value < 0)
+        out.append('-');
+    while (length)
+        out.append(digits[--length]);
+}
+
+} // anonymous namespace
+
 FlarePlugin::FlarePlugin()
 {
 }
@@ -60,7 +189,20 @@ std::unique_ptr<Tiled::Map> FlarePlugin::read(const QString &fileName)
     // default to values of the original Flare alpha game.
     auto map = std::make_unique<Map>(Map::Isometric, 256, 256, 64, 32);
 
-    QTextStream stream (&file);
+    // Map the file into memory when possible, to avoid copying it
+    QByteArray contents;
+    const char *data = nullptr;
+    qint64 size = file.size();
+
+    if (uchar *mapped = size > 0 ? file.map(0, size) : nullptr) {
+        data = reinterpret_cast<const char*>(mapped);
+    } else {
+        contents = file.readAll();
+        data = contents.constData();
+        size = contents.size();
+    }
+
+    LineReader stream(data, size);
     QString line;
     QString sectionName;
     bool newsection = false;
@@ -187,17 +329,30 @@ std::unique_ptr<Tiled::Map> FlarePlugin::read(const QString &fileName)
                     }
                 } else if (key == QLatin1String("data")) {
                     for (int y=0; y < map->height(); y++) {
-                        line = stream.readLine();
-                        QStringList l = line.split(QChar(','));
-                        for (int x=0; x < qMin(map->width(), l.size()); x++) {
+                        const char *rowBegin;
+                        const char *rowEnd;
+                        if (!stream.readLine(rowBegin, rowEnd))
+                            break;
+
+                        const char *fieldBegin = rowBegin;
+                        for (int x=0; x < map->width(); x++) {
+                            auto fieldEnd = static_cast<const char*>(memchr(fieldBegin, ',', static_cast<size_t>(rowEnd - fieldBegin)));
+                            if (!fieldEnd)
+                                fieldEnd = rowEnd;
+
                             bool ok;
-                            int tileid = l[x].toInt(nullptr, base);
+                            int tileid = parseInt(fieldBegin, fieldEnd, base);
                             Cell c = gidMapper.gidToCell(tileid, ok);
                             if (!ok) {
                                 mError += tr("Error mapping tile id %1.").arg(tileid);
                                 return nullptr;
                             }
-                            tilelayer->setCell(x, y, c);
+                            if (!c.isEmpty())
+                                tilelayer->setCell(x, y, c);
+
+                            if (fieldEnd == rowEnd)
+                                break;
+                            fieldBegin = fieldEnd + 1;
                         }
                     }
                 } else {
@@ -349,17 +504,22 @@ bool FlarePlugin::write(const Tiled::Map *map, const QString &fileName, Options
             out << "[layer]\n";
             out << "type=" << layer->name() << "\n";
             out << "data=\n";
+
+            // Format each row into a buffer before writing it out
+            QByteArray row;
+            row.reserve(mapWidth * 4 + 2);
+
             for (int y = 0; y < mapHeight; ++y) {
-                for (int x = 0; x < mapWidth; ++x) {
-                    Cell t = tileLayer->cellAt(x, y);
-                    int id = gidMapper.cellToGid(t);
-                    out << id;
+                row.resize(0);
+                tileLayer->forEachCellInRow(y, 0, mapWidth, [&] (int x, const Cell &cell) {
+                    appendNumber(row, static_cast<int>(gidMapper.cellToGid(cell)));
                     if (x < mapWidth - 1)
-                        out << ",";
-                }
+                        row.append(',');
+                });
                 if (y < mapHeight - 1)
-                    out << ",";
-                out << "\n";
+                    row.append(',');
+                row.append('\n');
+                out << QLatin1String(row.constData(), row.size());
             }
             //Write all properties for this layer
             Properties::const_iterator it = tileLayer->properties().constBegin();
@@ -405,6 +565,8 @@ bool FlarePlugin::write(const Tiled::Map *map, const QString &fileName, Options
         }
     }
 
+    out.flush();
+
     if (!file.commit()) {
         mError = file.errorString();
         return false;
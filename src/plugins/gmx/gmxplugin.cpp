@@ -31,6 +31,7 @@
 #include <QCoreApplication>
 #include <QDir>
 #include <QFileInfo>
+#include <QHash>
 #include <QRegularExpression>
 #include <QXmlStreamWriter>
 
@@ -78,6 +79,47 @@ static QString sanitizeName(QString name)
     return name.replace(regexp, QLatin1String("_"));
 }
 
+/**
+ * The attributes of a tile instance that depend only on the tile.
+ */
+struct TileSource
+{
+    QString bgName;
+    QString width;
+    QString height;
+    QString xOffset;
+    QString yOffset;
+};
+
+static TileSource tileSource(const Tile *tile)
+{
+    const Tileset *tileset = tile->tileset();
+
+    QString bgName;
+    int xo = 0;
+    int yo = 0;
+
+    if (tileset->isCollection()) {
+        bgName = QFileInfo(tile->imageSource().path()).baseName();
+    } else {
+        bgName = tileset->name();
+
+        int xInTilesetGrid = tile->id() % tileset->columnCount();
+        int yInTilesetGrid = tile->id() / tileset->columnCount();
+
+        xo = tileset->margin() + (tileset->tileSpacing() + tileset->tileWidth()) * xInTilesetGrid;
+        yo = tileset->margin() + (tileset->tileSpacing() + tileset->tileHeight()) * yInTilesetGrid;
+    }
+
+    return TileSource {
+        bgName,
+        QString::number(tile->width()),
+        QString::number(tile->height()),
+        QString::number(xo),
+        QString::number(yo)
+    };
+}
+
 static bool checkIfViewsDefined(const Map *map)
 {
     LayerIterator iterator(map);
@@ -110,7 +152,10 @@ bool GmxPlugin::write(const Map *map, const QString &fileName, Options options)
         return false;
     }
 
-    QXmlStreamWriter stream(file.device());
+    // Collect the output in memory, since writing it to the file piece by
+    // piece is slow for maps with many tiles
+    QString output;
+    QXmlStreamWriter stream(&output);
 
     stream.setAutoFormatting(!options.testFlag(WriteMinimized));
     stream.setAutoFormattingIndent(2);
@@ -291,13 +336,46 @@ bool GmxPlugin::write(const Map *map, const QString &fileName, Options options)
 
     uint tileId = 0u;
 
+    QHash<const Tile*, TileSource> tileSources;
+    auto sourceForTile = [&] (const Tile *tile) -> const TileSource & {
+        auto it = tileSources.find(tile);
+        if (it == tileSources.end())
+            it = tileSources.insert(tile, tileSource(tile));
+        return it.value();
+    };
+
+    auto writeTile = [&] (const TileSource &source,
+                          int x, int y, qreal scaleX, qreal scaleY,
+                          const QString &depth, const QString &locked, const QString &colour) {
+        stream.writeStartElement("tile");
+
+        stream.writeAttribute("bgName", source.bgName);
+        stream.writeAttribute("x", QString::number(x));
+        stream.writeAttribute("y", QString::number(y));
+        stream.writeAttribute("w", source.width);
+        stream.writeAttribute("h", source.height);
+
+        stream.writeAttribute("xo", source.xOffset);
+        stream.writeAttribute("yo", source.yOffset);
+
+        stream.writeAttribute("id", QString::number(++tileId));
+        stream.writeAttribute("depth", depth);
+        stream.writeAttribute("locked", locked);
+        stream.writeAttribute("colour", colour);
+
+        stream.writeAttribute("scaleX", QString::number(scaleX));
+        stream.writeAttribute("scaleY", QString::number(scaleY));
+
+        stream.writeEndElement();
+    };
+
     // Write out tile instances
     iterator.toFront();
     while (const Layer *layer = iterator.next()) {
         --layerCount;
         QString depth = QString::number(optionalProperty(layer, QLatin1String("depth"),
                                                          layerCount + 1000000));
-        const bool locked = !layer->isUnlocked();
+        const QString locked = toString(!layer->isUnlocked());
         auto color = layer->effectiveTintColor();
         color.setAlphaF(color.alphaF() * layer->effectiveOpacity());
         const auto colorString = QString::number(color.rgba());
@@ -307,13 +385,8 @@ bool GmxPlugin::write(const Map *map, const QString &fileName, Options options)
             auto tileLayer = static_cast<const TileLayer*>(layer);
 
             for (int y = 0; y < tileLayer->height(); ++y) {
-                for (int x = 0; x < tileLayer->width(); ++x) {
-                    const Cell &cell = tileLayer->cellAt(x, y);
+                tileLayer->forEachCellInRow(y, 0, tileLayer->width(), [&] (int x, const Cell &cell) {
                     if (const Tile *tile = cell.tile()) {
-                        const Tileset *tileset = tile->tileset();
-
-                        stream.writeStartElement("tile");
-
                         int pixelX = x * map->tileWidth();
                         int pixelY = y * map->tileHeight();
                         qreal scaleX = 1;
@@ -328,42 +401,10 @@ bool GmxPlugin::write(const Map *map, const QString &fileName, Options options)
                             pixelY += tile->height();
                         }
 
-                        QString bgName;
-                        int xo = 0;
-                        int yo = 0;
-
-                        if (tileset->isCollection()) {
-                            bgName = QFileInfo(tile->imageSource().path()).baseName();
-                        } else {
-                            bgName = tileset->name();
-
-                            int xInTilesetGrid = tile->id() % tileset->columnCount();
-                            int yInTilesetGrid = static_cast<int>(tile->id() / tileset->columnCount());
-
-                            xo = tileset->margin() + (tileset->tileSpacing() + tileset->tileWidth()) * xInTilesetGrid;
-                            yo = tileset->margin() + (tileset->tileSpacing() + tileset->tileHeight()) * yInTilesetGrid;
-                        }
-
-                        stream.writeAttribute("bgName", bgName);
-                        stream.writeAttribute("x", QString::number(pixelX));
-                        stream.writeAttribute("y", QString::number(pixelY));
-                        stream.writeAttribute("w", QString::number(tile->width()));
-                        stream.writeAttribute("h", QString::number(tile->height()));
-
-                        stream.writeAttribute("xo", QString::number(xo));
-                        stream.writeAttribute("yo", QString::number(yo));
-
-                        stream.writeAttribute("id", QString::number(++tileId));
-                        stream.writeAttribute("depth", depth);
-                        stream.writeAttribute("locked", toString(locked));
-                        stream.writeAttribute("colour", colorString);
-
-                        stream.writeAttribute("scaleX", QString::number(scaleX));
-                        stream.writeAttribute("scaleY", QString::number(scaleY));
-
-                        stream.writeEndElement();
+                        writeTile(sourceForTile(tile), pixelX, pixelY, scaleX, scaleY,
+                                  depth, locked, colorString);
                     }
-                }
+                });
             }
             break;
         }
@@ -386,8 +427,6 @@ bool GmxPlugin::write(const Map *map, const QString &fileName, Options options)
                 // Non-typed tile objects are exported as tiles. Rotation is
                 // not supported here, but scaling is.
                 if (const Tile *tile = object->cell().tile()) {
-                    const Tileset *tileset = tile->tileset();
-
                     const QSize tileSize = tile->size();
                     qreal scaleX = object->width() / tileSize.width();
                     qreal scaleY = object->height() / tileSize.height();
@@ -403,42 +442,8 @@ bool GmxPlugin::write(const Map *map, const QString &fileName, Options options)
                         y += object->height();
                     }
 
-                    stream.writeStartElement("tile");
-
-                    QString bgName;
-                    int xo = 0;
-                    int yo = 0;
-
-                    if (tileset->isCollection()) {
-                        bgName = QFileInfo(tile->imageSource().path()).baseName();
-                    } else {
-                        bgName = tileset->name();
-
-                        int xInTilesetGrid = tile->id() % tileset->columnCount();
-                        int yInTilesetGrid = tile->id() / tileset->columnCount();
-
-                        xo = tileset->margin() + (tileset->tileSpacing() + tileset->tileWidth()) * xInTilesetGrid;
-                        yo = tileset->margin() + (tileset->tileSpacing() + tileset->tileHeight()) * yInTilesetGrid;
-                    }
-
-                    stream.writeAttribute("bgName", bgName);
-                    stream.writeAttribute("x", QString::number(qRound(x)));
-                    stream.writeAttribute("y", QString::number(qRound(y)));
-                    stream.writeAttribute("w", QString::number(tile->width()));
-                    stream.writeAttribute("h", QString::number(tile->height()));
-
-                    stream.writeAttribute("xo", QString::number(xo));
-                    stream.writeAttribute("yo", QString::number(yo));
-
-                    stream.writeAttribute("id", QString::number(++tileId));
-                    stream.writeAttribute("depth", depth);
-                    stream.writeAttribute("locked", toString(locked));
-                    stream.writeAttribute("colour", colorString);
-
-                    stream.writeAttribute("scaleX", QString::number(scaleX));
-                    stream.writeAttribute("scaleY", QString::number(scaleY));
-
-                    stream.writeEndElement();
+                    writeTile(sourceForTile(tile), qRound(x), qRound(y), scaleX, scaleY,
+                              depth, locked, colorString);
                 } else {
                     Tiled::WARNING(QString(QLatin1String("GMX plugin: Ignoring non-tile object %1 without type.")).arg(object->id()),
                                    Tiled::JumpToObject { object });
@@ -472,6 +477,8 @@ bool GmxPlugin::write(const Map *map, const QString &fileName, Options options)
 
     stream.writeEndDocument();
 
+    file.device()->write(output.toUtf8());
+
     if (!file.commit()) {
         mError = file.errorString();
         return false;
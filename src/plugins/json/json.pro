@@ -3,8 +3,10 @@ include(../plugin.pri)
 DEFINES += JSON_LIBRARY
 
 SOURCES += jsonplugin.cpp \
+    jsontilesetreader.cpp \
     qjsonparser/json.cpp
 
 HEADERS += jsonplugin.h \
+    jsontilesetreader.h \
     json_global.h \
     qjsonparser/json.h
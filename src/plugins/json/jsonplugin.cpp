@@ -21,6 +21,8 @@
 
 #include "jsonplugin.h"
 
+#include "jsonscanner.h"
+#include "jsontilesetreader.h"
 #include "maptovariantconverter.h"
 #include "varianttomapconverter.h"
 #include "savefile.h"
@@ -31,11 +33,109 @@
 #include <QFile>
 #include <QFileInfo>
 #include <QJsonDocument>
-#include <QJsonObject>
 #include <QTextStream>
 
 namespace Json {
 
+namespace {
+
+/**
+ * Calls \a function for the members of the top-level JSON object at the
+ * start of the given file, like JsonScanner::forEachTopLevelMember. The
+ * \a header is used when given, otherwise it is read from the file.
+ *
+ * Only the first few kilobytes are looked at, which keeps detecting the kind
+ * of a large file cheap. The members are written in alphabetical order, so
+ * the ones identifying the kind of file are not always among them, but the
+ * members before any large value usually are.
+ */
+template<typename Function>
+void forEachTopLevelMember(const QString &fileName, const QByteArray *header,
+                           bool jsonp, Function function)
+{
+    QByteArray data;
+
+    if (!header) {
+        QFile file(fileName);
+        if (!file.open(QIODevice::ReadOnly))
+            return;
+
+        data = file.read(Tiled::FileFormat::FileHeaderSize);
+        header = &data;
+    }
+
+    const char *begin = header->constData();
+    Tiled::JsonScanner::forEachTopLevelMember(begin, begin + header->size(), jsonp, function);
+}
+
+bool isMapFile(const QString &fileName, const QByteArray *header, bool jsonp)
+{
+    bool supported = false;
+
+    forEachTopLevelMember(fileName, header, jsonp, [&] (QLatin1String key, QLatin1String value) {
+        // This is a good indication, but not present in older map files
+        if (key == QLatin1String("type") && value == QLatin1String("map"))
+            supported = true;
+
+        // Guess based on expected properties. The layers are usually found
+        // before the others, though they may not fit in the header.
+        if (key == QLatin1String("orientation") || key == QLatin1String("layers"))
+            supported = true;
+
+        return !supported;
+    });
+
+    return supported;
+}
+
+bool isTilesetFile(const QString &fileName, const QByteArray *header)
+{
+    bool supported = false;
+    bool hasName = false;
+    bool hasTileWidth = false;
+    bool hasTileHeight = false;
+    bool hasTileCount = false;
+
+    forEachTopLevelMember(fileName, header, false, [&] (QLatin1String key, QLatin1String value) {
+        // This is a good indication, but not present in older external tilesets
+        if (key == QLatin1String("type") && value == QLatin1String("tileset"))
+            supported = true;
+
+        // Guess based on some expected properties
+        if (key == QLatin1String("name"))
+            hasName = true;
+        else if (key == QLatin1String("tilewidth"))
+            hasTileWidth = true;
+        else if (key == QLatin1String("tileheight"))
+            hasTileHeight = true;
+        else if (key == QLatin1String("tilecount"))
+            hasTileCount = true;
+
+        // The tile width may follow the tiles, which may not fit in the header
+        if (hasName && hasTileHeight && (hasTileWidth || hasTileCount))
+            supported = true;
+
+        return !supported;
+    });
+
+    return supported;
+}
+
+bool isTemplateFile(const QString &fileName, const QByteArray *header)
+{
+    bool supported = false;
+
+    forEachTopLevelMember(fileName, header, false, [&] (QLatin1String key, QLatin1String value) {
+        if (key == QLatin1String("type"))
+            supported = value == QLatin1String("template");
+        return key != QLatin1String("type");
+    });
+
+    return supported;
+}
+
+} // anonymous namespace
+
 void JsonPlugin::initialize()
 {
     addObject(new JsonMapFormat(JsonMapFormat::Json, this));
@@ -163,41 +263,21 @@ QString JsonMapFormat::shortName() const
 
 bool JsonMapFormat::supportsFile(const QString &fileName) const
 {
-    if (mSubFormat == Json) {
-        if (!fileName.endsWith(QLatin1String(".json"), Qt::CaseInsensitive))
-            return false;
-    } else {
-        if (!fileName.endsWith(QLatin1String(".js"), Qt::CaseInsensitive))
-            return false;
-    }
-
-    QFile file(fileName);
-    if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        QByteArray contents = file.readAll();
-
-        if (mSubFormat == JavaScript && contents.size() > 0 && contents[0] != '{') {
-            // Scan past JSONP prefix; look for an open curly at the start of the line
-            int i = contents.indexOf(QLatin1String("\n{"));
-            if (i > 0) {
-                contents.remove(0, i);
-                contents = contents.trimmed(); // potential trailing whitespace
-                if (contents.endsWith(';')) contents.chop(1);
-                if (contents.endsWith(')')) contents.chop(1);
-            }
-        }
-
-        const QJsonObject object = QJsonDocument::fromJson(contents).object();
-
-        // This is a good indication, but not present in older map files
-        if (object.value(QLatin1String("type")).toString() == QLatin1String("map"))
-            return true;
+    return hasExtension(fileName) && isMapFile(fileName, nullptr, mSubFormat == JavaScript);
+}
 
-        // Guess based on expected property
-        if (object.contains(QLatin1String("orientation")))
-            return true;
-    }
+bool JsonMapFormat::supportsFileHeader(const QString &fileName,
+                                       const QByteArray &header) const
+{
+    return hasExtension(fileName) && isMapFile(fileName, &header, mSubFormat == JavaScript);
+}
 
-    return false;
+bool JsonMapFormat::hasExtension(const QString &fileName) const
+{
+    if (mSubFormat == Json)
+        return fileName.endsWith(QLatin1String(".json"), Qt::CaseInsensitive);
+    else
+        return fileName.endsWith(QLatin1String(".js"), Qt::CaseInsensitive);
 }
 
 QString JsonMapFormat::errorString() const
@@ -220,47 +300,34 @@ Tiled::SharedTileset JsonTilesetFormat::read(const QString &fileName)
         return Tiled::SharedTileset();
     }
 
-    JsonReader reader;
-    reader.parse(file.readAll());
-
-    const QVariant variant = reader.result();
-
-    if (!variant.isValid()) {
+    // Tilesets and templates are read without the detour through QVariant
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll());
+    if (!document.isObject()) {
         mError = tr("Error parsing file.");
         return Tiled::SharedTileset();
     }
 
-    Tiled::VariantToMapConverter converter;
-    Tiled::SharedTileset tileset = converter.toTileset(variant,
-                                                       QFileInfo(fileName).dir());
+    JsonTilesetReader reader;
+    Tiled::SharedTileset tileset = reader.readTileset(document.object(),
+                                                      QFileInfo(fileName).dir());
 
     if (!tileset)
-        mError = converter.errorString();
+        mError = reader.errorString();
 
     return tileset;
 }
 
 bool JsonTilesetFormat::supportsFile(const QString &fileName) const
 {
-    if (fileName.endsWith(QLatin1String(".json"), Qt::CaseInsensitive)) {
-        QFile file(fileName);
-
-        if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            const QJsonObject object = QJsonDocument::fromJson(file.readAll()).object();
-
-            // This is a good indication, but not present in older external tilesets
-            if (object.value(QLatin1String("type")).toString() == QLatin1String("tileset"))
-                return true;
-
-            // Guess based on some expected properties
-            if (object.contains(QLatin1String("name")) &&
-                object.contains(QLatin1String("tilewidth")) &&
-                object.contains(QLatin1String("tileheight")))
-                return true;
-        }
-    }
+    return fileName.endsWith(QLatin1String(".json"), Qt::CaseInsensitive) &&
+            isTilesetFile(fileName, nullptr);
+}
 
-    return false;
+bool JsonTilesetFormat::supportsFileHeader(const QString &fileName,
+                                           const QByteArray &header) const
+{
+    return fileName.endsWith(QLatin1String(".json"), Qt::CaseInsensitive) &&
+            isTilesetFile(fileName, &header);
 }
 
 bool JsonTilesetFormat::write(const Tiled::Tileset &tileset,
@@ -331,22 +398,18 @@ std::unique_ptr<Tiled::ObjectTemplate> JsonObjectTemplateFormat::read(const QStr
         return nullptr;
     }
 
-    JsonReader reader;
-    reader.parse(file.readAll());
-
-    const QVariant variant = reader.result();
-
-    if (!variant.isValid()) {
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll());
+    if (!document.isObject()) {
         mError = tr("Error parsing file.");
         return nullptr;
     }
 
-    Tiled::VariantToMapConverter converter;
-    auto objectTemplate = converter.toObjectTemplate(variant,
-                                                     QFileInfo(fileName).dir());
+    JsonTilesetReader reader;
+    auto objectTemplate = reader.readObjectTemplate(document.object(),
+                                                    QFileInfo(fileName).dir());
 
     if (!objectTemplate)
-        mError = converter.errorString();
+        mError = reader.errorString();
     else
         objectTemplate->setFileName(fileName);
 
@@ -355,18 +418,15 @@ std::unique_ptr<Tiled::ObjectTemplate> JsonObjectTemplateFormat::read(const QStr
 
 bool JsonObjectTemplateFormat::supportsFile(const QString &fileName) const
 {
-    if (fileName.endsWith(QLatin1String(".json"), Qt::CaseInsensitive)) {
-        QFile file(fileName);
-
-        if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            const QJsonObject object = QJsonDocument::fromJson(file.readAll()).object();
-
-            if (object.value(QLatin1String("type")).toString() == QLatin1String("template"))
-                return true;
-        }
-    }
+    return fileName.endsWith(QLatin1String(".json"), Qt::CaseInsensitive) &&
+            isTemplateFile(fileName, nullptr);
+}
 
-    return false;
+bool JsonObjectTemplateFormat::supportsFileHeader(const QString &fileName,
+                                                  const QByteArray &header) const
+{
+    return fileName.endsWith(QLatin1String(".json"), Qt::CaseInsensitive) &&
+            isTemplateFile(fileName, &header);
 }
 
 bool JsonObjectTemplateFormat::write(const Tiled::ObjectTemplate *objectTemplate, const QString &fileName)
@@ -62,6 +62,8 @@ public:
 
     std::unique_ptr<Tiled::Map> read(const QString &fileName) override;
     bool supportsFile(const QString &fileName) const override;
+    bool supportsFileHeader(const QString &fileName,
+                            const QByteArray &header) const override;
 
     bool write(const Tiled::Map *map, const QString &fileName, Options options) override;
 
@@ -70,6 +72,8 @@ public:
     QString errorString() const override;
 
 protected:
+    bool hasExtension(const QString &fileName) const;
+
     QString mError;
     SubFormat mSubFormat;
 };
@@ -85,6 +89,8 @@ public:
 
     Tiled::SharedTileset read(const QString &fileName) override;
     bool supportsFile(const QString &fileName) const override;
+    bool supportsFileHeader(const QString &fileName,
+                            const QByteArray &header) const override;
 
     bool write(const Tiled::Tileset &tileset, const QString &fileName, Options options) override;
 
@@ -106,6 +112,8 @@ public:
 
     std::unique_ptr<Tiled::ObjectTemplate> read(const QString &fileName) override;
     bool supportsFile(const QString &fileName) const override;
+    bool supportsFileHeader(const QString &fileName,
+                            const QByteArray &header) const override;
 
     bool write(const Tiled::ObjectTemplate *objectTemplate, const QString &fileName) override;
 
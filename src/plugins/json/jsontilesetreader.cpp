@@ -0,0 +1,551 @@
+/*
+ * JSON Tiled Plugin
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "jsontilesetreader.h"
+
+#include "objectgroup.h"
+#include "objecttemplate.h"
+#include "properties.h"
+#include "templatemanager.h"
+#include "terrain.h"
+#include "tile.h"
+#include "tilesetmanager.h"
+#include "wangset.h"
+
+#include <QFileInfo>
+#include <QJsonArray>
+
+using namespace Tiled;
+
+namespace Json {
+
+static QString resolvePath(const QDir &dir, const QJsonValue &value)
+{
+    QString fileName = value.toString();
+    if (!fileName.isEmpty() && QDir::isRelativePath(fileName))
+        return QDir::cleanPath(dir.absoluteFilePath(fileName));
+    return fileName;
+}
+
+SharedTileset JsonTilesetReader::readTileset(const QJsonObject &json,
+                                             const QDir &directory)
+{
+    mDir = directory;
+
+    SharedTileset tileset = readTileset(json, true);
+    if (tileset && !tileset->imageSource().isEmpty())
+        tileset->loadImage();
+
+    return tileset;
+}
+
+std::unique_ptr<ObjectTemplate> JsonTilesetReader::readObjectTemplate(const QJsonObject &json,
+                                                                      const QDir &directory)
+{
+    mGidMapper.clear();
+    mDir = directory;
+
+    const QJsonValue tileset = json.value(QLatin1String("tileset"));
+    if (tileset.isObject())
+        readTileset(tileset.toObject(), false);
+
+    std::unique_ptr<ObjectTemplate> objectTemplate(new ObjectTemplate);
+    objectTemplate->setObject(readMapObject(json.value(QLatin1String("object")).toObject()));
+
+    return objectTemplate;
+}
+
+SharedTileset JsonTilesetReader::readTileset(const QJsonObject &json, bool external)
+{
+    const unsigned firstGid = static_cast<unsigned>(json.value(QLatin1String("firstgid")).toDouble());
+
+    // Handle references to external tilesets
+    const QJsonValue source = json.value(QLatin1String("source"));
+    if (!source.isUndefined() && !source.isNull()) {
+        const QString fileName = resolvePath(mDir, source);
+        QString error;
+        SharedTileset tileset = TilesetManager::instance()->loadTileset(fileName, &error);
+        if (!tileset) {
+            // Insert a placeholder to allow the template to load
+            tileset = Tileset::create(QFileInfo(fileName).completeBaseName(), 32, 32);
+            tileset->setFileName(fileName);
+            tileset->setStatus(LoadingError);
+        } else {
+            mGidMapper.insert(firstGid, tileset);
+        }
+        return tileset;
+    }
+
+    const QString name = json.value(QLatin1String("name")).toString();
+    const int tileWidth = json.value(QLatin1String("tilewidth")).toInt();
+    const int tileHeight = json.value(QLatin1String("tileheight")).toInt();
+    const int spacing = json.value(QLatin1String("spacing")).toInt();
+    const int margin = json.value(QLatin1String("margin")).toInt();
+    const QJsonObject tileOffset = json.value(QLatin1String("tileoffset")).toObject();
+    const QJsonObject grid = json.value(QLatin1String("grid")).toObject();
+    const int columns = json.value(QLatin1String("columns")).toInt();
+    const QString backgroundColor = json.value(QLatin1String("backgroundcolor")).toString();
+    const QString objectAlignment = json.value(QLatin1String("objectalignment")).toString();
+
+    if (tileWidth <= 0 || tileHeight <= 0 || (firstGid == 0 && !external)) {
+        mError = tr("Invalid tileset parameters for tileset '%1'").arg(name);
+        return SharedTileset();
+    }
+
+    SharedTileset tileset(Tileset::create(name,
+                                          tileWidth, tileHeight,
+                                          spacing, margin));
+
+    tileset->setObjectAlignment(alignmentFromString(objectAlignment));
+    tileset->setTileOffset(QPoint(tileOffset.value(QLatin1String("x")).toInt(),
+                                  tileOffset.value(QLatin1String("y")).toInt()));
+    tileset->setColumnCount(columns);
+
+    const QJsonObject exportObject = json.value(QLatin1String("editorsettings")).toObject()
+            .value(QLatin1String("export")).toObject();
+    tileset->exportFileName = QDir::cleanPath(mDir.filePath(exportObject.value(QLatin1String("target")).toString()));
+    tileset->exportFormat = exportObject.value(QLatin1String("format")).toString();
+
+    if (!grid.isEmpty()) {
+        const QString orientation = grid.value(QLatin1String("orientation")).toString();
+        const QSize gridSize(grid.value(QLatin1String("width")).toInt(),
+                             grid.value(QLatin1String("height")).toInt());
+
+        tileset->setOrientation(Tileset::orientationFromString(orientation));
+        if (!gridSize.isEmpty())
+            tileset->setGridSize(gridSize);
+    }
+
+    if (QColor::isValidColor(backgroundColor))
+        tileset->setBackgroundColor(QColor(backgroundColor));
+
+    const QJsonValue image = json.value(QLatin1String("image"));
+    if (!image.isUndefined() && !image.isNull()) {
+        ImageReference imageRef;
+        imageRef.source = toUrl(image.toString(), mDir);
+        imageRef.size = QSize(json.value(QLatin1String("imagewidth")).toInt(),
+                              json.value(QLatin1String("imageheight")).toInt());
+
+        tileset->setImageReference(imageRef);
+    }
+
+    const QString trans = json.value(QLatin1String("transparentcolor")).toString();
+    if (QColor::isValidColor(trans))
+        tileset->setTransparentColor(QColor(trans));
+
+    tileset->setProperties(readProperties(json));
+
+    const QJsonArray terrains = json.value(QLatin1String("terrains")).toArray();
+    for (const QJsonValue &value : terrains) {
+        const QJsonObject terrainObject = value.toObject();
+        Terrain *terrain = tileset->addTerrain(terrainObject.value(QLatin1String("name")).toString(),
+                                               terrainObject.value(QLatin1String("tile")).toInt());
+        terrain->setProperties(readProperties(terrainObject));
+    }
+
+    const QJsonValue tiles = json.value(QLatin1String("tiles"));
+
+    // Read tiles (1.0 format)
+    const QJsonObject tilesObject = tiles.toObject();
+    for (auto it = tilesObject.begin(), it_end = tilesObject.end(); it != it_end; ++it) {
+        const int tileId = it.key().toInt();
+        if (tileId < 0) {
+            mError = tr("Invalid (negative) tile id: %1").arg(tileId);
+            return SharedTileset();
+        }
+
+        readTile(*tileset, tileset->findOrCreateTile(tileId), it.value().toObject());
+    }
+
+    // Read tile properties (1.0 format)
+    const QJsonObject tileProperties = json.value(QLatin1String("tileproperties")).toObject();
+    const QJsonObject tilePropertyTypes = json.value(QLatin1String("tilepropertytypes")).toObject();
+    for (auto it = tileProperties.begin(), it_end = tileProperties.end(); it != it_end; ++it) {
+        const int tileId = it.key().toInt();
+        const Properties properties = readProperties(it.value(), tilePropertyTypes.value(it.key()));
+        tileset->findOrCreateTile(tileId)->setProperties(properties);
+    }
+
+    // Read the tiles saved as a list (1.2 format)
+    const QJsonArray tilesArray = tiles.toArray();
+    for (const QJsonValue &value : tilesArray) {
+        const QJsonObject tileObject = value.toObject();
+        const int tileId = tileObject.value(QLatin1String("id")).toInt();
+        if (tileId < 0) {
+            mError = tr("Invalid (negative) tile id: %1").arg(tileId);
+            return SharedTileset();
+        }
+
+        Tile *tile = tileset->findOrCreateTile(tileId);
+        readTile(*tileset, tile, tileObject);
+        tile->setProperties(readProperties(tileObject));
+    }
+
+    const QJsonArray wangSets = json.value(QLatin1String("wangsets")).toArray();
+    for (const QJsonValue &value : wangSets) {
+        if (auto wangSet = readWangSet(value.toObject(), tileset.data()))
+            tileset->addWangSet(std::move(wangSet));
+        else
+            return SharedTileset();
+    }
+
+    if (!external)
+        mGidMapper.insert(firstGid, tileset);
+
+    return tileset;
+}
+
+/**
+ * Reads tile information (everything except the properties).
+ */
+void JsonTilesetReader::readTile(Tileset &tileset, Tile *tile, const QJsonObject &json)
+{
+    tile->setType(json.value(QLatin1String("type")).toString());
+
+    const QJsonArray terrains = json.value(QLatin1String("terrain")).toArray();
+    if (terrains.size() == 4) {
+        for (int i = 0; i < 4; ++i) {
+            const QJsonValue terrainId = terrains.at(i);
+            if (terrainId.isDouble() && terrainId.toInt() >= 0 && terrainId.toInt() < tileset.terrainCount())
+                tile->setCornerTerrainId(i, terrainId.toInt());
+        }
+    }
+
+    const QJsonValue probability = json.value(QLatin1String("probability"));
+    if (probability.isDouble())
+        tile->setProbability(probability.toDouble());
+
+    const QJsonValue image = json.value(QLatin1String("image"));
+    if (!image.isUndefined() && !image.isNull()) {
+        const QUrl imagePath = toUrl(image.toString(), mDir);
+        tileset.setTileImage(tile, QPixmap(imagePath.toLocalFile()), imagePath);
+    }
+
+    const QJsonObject objectGroupObject = json.value(QLatin1String("objectgroup")).toObject();
+    if (!objectGroupObject.isEmpty()) {
+        if (std::unique_ptr<ObjectGroup> objectGroup = readObjectGroup(objectGroupObject)) {
+            // Migrate properties from the object group to the tile. Since
+            // Tiled 1.1, it is no longer possible to edit the properties of
+            // this implicit object group, but some users may have set them
+            // in previous versions.
+            Properties properties = readProperties(objectGroupObject);
+            if (!properties.isEmpty()) {
+                mergeProperties(properties, tile->properties());
+                tile->setProperties(properties);
+            }
+
+            tile->setObjectGroup(std::move(objectGroup));
+        }
+    }
+
+    const QJsonArray frameArray = json.value(QLatin1String("animation")).toArray();
+    if (!frameArray.isEmpty()) {
+        QVector<Frame> frames;
+        frames.reserve(frameArray.size());
+        for (const QJsonValue &value : frameArray) {
+            const QJsonObject frameObject = value.toObject();
+            Frame frame;
+            frame.tileId = frameObject.value(QLatin1String("tileid")).toInt();
+            frame.duration = frameObject.value(QLatin1String("duration")).toInt();
+            frames.append(frame);
+        }
+        tile->setFrames(frames);
+    }
+}
+
+std::unique_ptr<WangSet> JsonTilesetReader::readWangSet(const QJsonObject &json, Tileset *tileset)
+{
+    const QString name = json.value(QLatin1String("name")).toString();
+    const int tile = json.value(QLatin1String("tile")).toInt();
+
+    std::unique_ptr<WangSet> wangSet { new WangSet(tileset, name, tile) };
+
+    wangSet->setProperties(readProperties(json));
+
+    const QJsonArray edgeColors = json.value(QLatin1String("edgecolors")).toArray();
+    for (const QJsonValue &value : edgeColors)
+        wangSet->addWangColor(readWangColor(value.toObject(), true));
+
+    const QJsonArray cornerColors = json.value(QLatin1String("cornercolors")).toArray();
+    for (const QJsonValue &value : cornerColors)
+        wangSet->addWangColor(readWangColor(value.toObject(), false));
+
+    const QJsonArray wangTiles = json.value(QLatin1String("wangtiles")).toArray();
+    for (const QJsonValue &value : wangTiles) {
+        const QJsonObject wangTileObject = value.toObject();
+
+        const int tileId = wangTileObject.value(QLatin1String("tileid")).toInt();
+        const QJsonArray wangIdArray = wangTileObject.value(QLatin1String("wangid")).toArray();
+
+        WangId wangId;
+        bool ok = wangIdArray.size() >= 8;
+        for (int i = 0; i < 8 && ok; ++i) {
+            const double color = wangIdArray.at(i).toDouble(-1);
+            ok = color >= 0;
+            wangId.setIndexColor(i, static_cast<unsigned>(color));
+        }
+
+        if (!ok || !wangSet->wangIdIsValid(wangId)) {
+            mError = QLatin1String("Invalid wangId given for tileId: ") + QString::number(tileId);
+            return nullptr;
+        }
+
+        WangTile wangTile(tileset->findOrCreateTile(tileId), wangId);
+        wangTile.setFlippedHorizontally(wangTileObject.value(QLatin1String("hflip")).toBool());
+        wangTile.setFlippedVertically(wangTileObject.value(QLatin1String("vflip")).toBool());
+        wangTile.setFlippedAntiDiagonally(wangTileObject.value(QLatin1String("dflip")).toBool());
+
+        wangSet->addWangTile(wangTile);
+    }
+
+    return wangSet;
+}
+
+QSharedPointer<WangColor> JsonTilesetReader::readWangColor(const QJsonObject &json,
+                                                           bool isEdge) const
+{
+    return QSharedPointer<WangColor>::create(0,
+                                             isEdge,
+                                             json.value(QLatin1String("name")).toString(),
+                                             QColor(json.value(QLatin1String("color")).toString()),
+                                             json.value(QLatin1String("tile")).toInt(),
+                                             json.value(QLatin1String("probability")).toDouble());
+}
+
+std::unique_ptr<ObjectGroup> JsonTilesetReader::readObjectGroup(const QJsonObject &json)
+{
+    std::unique_ptr<ObjectGroup> objectGroup(new ObjectGroup(json.value(QLatin1String("name")).toString(),
+                                                             json.value(QLatin1String("x")).toInt(),
+                                                             json.value(QLatin1String("y")).toInt()));
+
+    objectGroup->setColor(QColor(json.value(QLatin1String("color")).toString()));
+
+    const QString drawOrderString = json.value(QLatin1String("draworder")).toString();
+    if (!drawOrderString.isEmpty()) {
+        objectGroup->setDrawOrder(drawOrderFromString(drawOrderString));
+        if (objectGroup->drawOrder() == ObjectGroup::UnknownOrder) {
+            mError = tr("Invalid draw order: %1").arg(drawOrderString);
+            return nullptr;
+        }
+    }
+
+    const QJsonArray objects = json.value(QLatin1String("objects")).toArray();
+    for (const QJsonValue &value : objects)
+        objectGroup->addObject(readMapObject(value.toObject()));
+
+    return objectGroup;
+}
+
+std::unique_ptr<MapObject> JsonTilesetReader::readMapObject(const QJsonObject &json)
+{
+    const QString name = json.value(QLatin1String("name")).toString();
+    const QString type = json.value(QLatin1String("type")).toString();
+    const int id = json.value(QLatin1String("id")).toInt();
+    const unsigned gid = static_cast<unsigned>(json.value(QLatin1String("gid")).toDouble());
+    const QJsonValue templateValue = json.value(QLatin1String("template"));
+    const qreal width = json.value(QLatin1String("width")).toDouble();
+    const qreal height = json.value(QLatin1String("height")).toDouble();
+
+    const QPointF pos(json.value(QLatin1String("x")).toDouble(),
+                      json.value(QLatin1String("y")).toDouble());
+    const QSizeF size(width, height);
+
+    auto object = std::make_unique<MapObject>(name, type, pos, size);
+    object->setId(id);
+
+    const QJsonValue rotation = json.value(QLatin1String("rotation"));
+    if (!rotation.isUndefined()) {
+        object->setRotation(rotation.toDouble());
+        object->setPropertyChanged(MapObject::RotationProperty);
+    }
+
+    if (templateValue.isString()) { // This object is a template instance
+        const QString templateFileName = resolvePath(mDir, templateValue);
+        object->setObjectTemplate(TemplateManager::instance()->loadObjectTemplate(templateFileName));
+    }
+
+    object->setPropertyChanged(MapObject::NameProperty, !name.isEmpty());
+    object->setPropertyChanged(MapObject::TypeProperty, !type.isEmpty());
+    object->setPropertyChanged(MapObject::SizeProperty, !size.isEmpty());
+
+    if (gid) {
+        bool ok;
+        object->setCell(mGidMapper.gidToCell(gid, ok));
+
+        if (const Tile *tile = object->cell().tile()) {
+            const QSizeF &tileSize = tile->size();
+            if (width == 0)
+                object->setWidth(tileSize.width());
+            if (height == 0)
+                object->setHeight(tileSize.height());
+        }
+
+        object->setPropertyChanged(MapObject::CellProperty);
+    }
+
+    const QJsonValue visible = json.value(QLatin1String("visible"));
+    if (!visible.isUndefined()) {
+        object->setVisible(visible.toBool());
+        object->setPropertyChanged(MapObject::VisibleProperty);
+    }
+
+    object->setProperties(readProperties(json));
+
+    const QJsonValue polygon = json.value(QLatin1String("polygon"));
+    const QJsonValue polyline = json.value(QLatin1String("polyline"));
+    const QJsonValue text = json.value(QLatin1String("text"));
+
+    if (polygon.isArray()) {
+        object->setShape(MapObject::Polygon);
+        object->setPolygon(readPolygon(polygon.toArray()));
+        object->setPropertyChanged(MapObject::ShapeProperty);
+    }
+    if (polyline.isArray()) {
+        object->setShape(MapObject::Polyline);
+        object->setPolygon(readPolygon(polyline.toArray()));
+        object->setPropertyChanged(MapObject::ShapeProperty);
+    }
+    if (json.value(QLatin1String("ellipse")).toBool()) {
+        object->setShape(MapObject::Ellipse);
+        object->setPropertyChanged(MapObject::ShapeProperty);
+    }
+    if (json.value(QLatin1String("point")).toBool()) {
+        object->setShape(MapObject::Point);
+        object->setPropertyChanged(MapObject::ShapeProperty);
+    }
+    if (text.isObject()) {
+        object->setTextData(readTextData(text.toObject()));
+        object->setShape(MapObject::Text);
+        object->setPropertyChanged(MapObject::TextProperty);
+    }
+
+    object->syncWithTemplate();
+
+    return object;
+}
+
+QPolygonF JsonTilesetReader::readPolygon(const QJsonArray &json) const
+{
+    QPolygonF polygon;
+    polygon.reserve(json.size());
+    for (const QJsonValue &value : json) {
+        const QJsonObject point = value.toObject();
+        polygon.append(QPointF(point.value(QLatin1String("x")).toDouble(),
+                               point.value(QLatin1String("y")).toDouble()));
+    }
+    return polygon;
+}
+
+TextData JsonTilesetReader::readTextData(const QJsonObject &json) const
+{
+    TextData textData;
+
+    const QString family = json.value(QLatin1String("fontfamily")).toString();
+    const int pixelSize = json.value(QLatin1String("pixelsize")).toInt();
+
+    if (!family.isEmpty())
+        textData.font.setFamily(family);
+    if (pixelSize > 0)
+        textData.font.setPixelSize(pixelSize);
+
+    // Booleans used to be written as 0 or 1
+    auto toBool = [&] (const char *key) {
+        const QJsonValue value = json.value(QLatin1String(key));
+        return value.isBool() ? value.toBool() : value.toInt() == 1;
+    };
+
+    textData.wordWrap = toBool("wrap");
+    textData.font.setBold(toBool("bold"));
+    textData.font.setItalic(toBool("italic"));
+    textData.font.setUnderline(toBool("underline"));
+    textData.font.setStrikeOut(toBool("strikeout"));
+    if (json.contains(QLatin1String("kerning")))
+        textData.font.setKerning(toBool("kerning"));
+
+    const QString colorString = json.value(QLatin1String("color")).toString();
+    if (!colorString.isEmpty())
+        textData.color = QColor(colorString);
+
+    Qt::Alignment alignment;
+
+    const QString hAlignString = json.value(QLatin1String("halign")).toString();
+    if (hAlignString == QLatin1String("center"))
+        alignment |= Qt::AlignHCenter;
+    else if (hAlignString == QLatin1String("right"))
+        alignment |= Qt::AlignRight;
+    else if (hAlignString == QLatin1String("justify"))
+        alignment |= Qt::AlignJustify;
+    else
+        alignment |= Qt::AlignLeft;
+
+    const QString vAlignString = json.value(QLatin1String("valign")).toString();
+    if (vAlignString == QLatin1String("center"))
+        alignment |= Qt::AlignVCenter;
+    else if (vAlignString == QLatin1String("bottom"))
+        alignment |= Qt::AlignBottom;
+    else
+        alignment |= Qt::AlignTop;
+
+    textData.alignment = alignment;
+    textData.text = json.value(QLatin1String("text")).toString();
+
+    return textData;
+}
+
+Properties JsonTilesetReader::readProperties(const QJsonValue &properties,
+                                             const QJsonValue &propertyTypes) const
+{
+    Properties result;
+
+    // Only the property values themselves are converted to QVariant
+    auto propertyValue = [this] (const QJsonValue &value, const QString &typeName) {
+        int type = nameToType(typeName);
+        if (type == QVariant::Invalid)
+            type = QVariant::String;
+        return fromExportValue(value.toVariant(), type, mDir);
+    };
+
+    // Read object-based format (1.0)
+    const QJsonObject propertiesObject = properties.toObject();
+    const QJsonObject propertyTypesObject = propertyTypes.toObject();
+    for (auto it = propertiesObject.begin(), it_end = propertiesObject.end(); it != it_end; ++it) {
+        const QString typeName = propertyTypesObject.value(it.key()).toString();
+        result.insert(it.key(), propertyValue(it.value(), typeName));
+    }
+
+    // Read array-based format (1.2)
+    const QJsonArray propertiesArray = properties.toArray();
+    for (const QJsonValue &value : propertiesArray) {
+        const QJsonObject property = value.toObject();
+        result.insert(property.value(QLatin1String("name")).toString(),
+                      propertyValue(property.value(QLatin1String("value")),
+                                    property.value(QLatin1String("type")).toString()));
+    }
+
+    return result;
+}
+
+Properties JsonTilesetReader::readProperties(const QJsonObject &json) const
+{
+    return readProperties(json.value(QLatin1String("properties")),
+                          json.value(QLatin1String("propertytypes")));
+}
+
+} // namespace Json
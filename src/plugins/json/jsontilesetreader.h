@@ -0,0 +1,91 @@
+/*
+ * JSON Tiled Plugin
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "gidmapper.h"
+#include "mapobject.h"
+#include "tileset.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QJsonObject>
+
+#include <memory>
+
+namespace Tiled {
+class ObjectGroup;
+class ObjectTemplate;
+class WangColor;
+class WangSet;
+}
+
+namespace Json {
+
+/**
+ * Reads tilesets and templates straight from a QJsonObject.
+ *
+ * Unlike the VariantToMapConverter, which is still used for maps, this
+ * avoids converting the whole document to a tree of QVariant values first.
+ */
+class JsonTilesetReader
+{
+    // Using the MapReader context since the messages are the same
+    Q_DECLARE_TR_FUNCTIONS(MapReader)
+
+public:
+    /**
+     * Reads an external tileset. The \a directory is necessary to resolve
+     * any relative references to images.
+     *
+     * Returns a null tileset in case of an error, which can be obtained
+     * using errorString().
+     */
+    Tiled::SharedTileset readTileset(const QJsonObject &json, const QDir &directory);
+
+    /**
+     * Reads an object template. The \a directory is necessary to resolve
+     * any relative references to tilesets.
+     */
+    std::unique_ptr<Tiled::ObjectTemplate> readObjectTemplate(const QJsonObject &json,
+                                                              const QDir &directory);
+
+    QString errorString() const { return mError; }
+
+private:
+    Tiled::SharedTileset readTileset(const QJsonObject &json, bool external);
+    void readTile(Tiled::Tileset &tileset, Tiled::Tile *tile, const QJsonObject &json);
+    std::unique_ptr<Tiled::WangSet> readWangSet(const QJsonObject &json, Tiled::Tileset *tileset);
+    QSharedPointer<Tiled::WangColor> readWangColor(const QJsonObject &json, bool isEdge) const;
+    std::unique_ptr<Tiled::ObjectGroup> readObjectGroup(const QJsonObject &json);
+    std::unique_ptr<Tiled::MapObject> readMapObject(const QJsonObject &json);
+    QPolygonF readPolygon(const QJsonArray &json) const;
+    Tiled::TextData readTextData(const QJsonObject &json) const;
+
+    Tiled::Properties readProperties(const QJsonValue &properties,
+                                     const QJsonValue &propertyTypes) const;
+    Tiled::Properties readProperties(const QJsonObject &json) const;
+
+    QDir mDir;
+    Tiled::GidMapper mGidMapper;
+    QString mError;
+};
+
+} // namespace Json
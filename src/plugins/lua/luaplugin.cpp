@@ -534,17 +534,22 @@ void LuaWriter::writeTileLayerData(const TileLayer *tileLayer,
 {
     switch (format) {
     case Map::XML:
-    case Map::CSV:
+    case Map::CSV: {
+        QVector<unsigned> gids(bounds.width());
+
         mWriter.writeStartTable("data");
         for (int y = bounds.top(); y <= bounds.bottom(); ++y) {
             if (y > bounds.top())
                 mWriter.prepareNewLine();
 
-            for (int x = bounds.left(); x <= bounds.right(); ++x)
-                mWriter.writeValue(mGidMapper.cellToGid(tileLayer->cellAt(x, y)));
+            tileLayer->forEachCellInRow(y, bounds.left(), bounds.right() + 1, [&] (int x, const Cell &cell) {
+                gids[x - bounds.left()] = mGidMapper.cellToGid(cell);
+            });
+            mWriter.writeValues(gids);
         }
         mWriter.writeEndTable();
         break;
+    }
 
     case Map::Base64:
     case Map::Base64Zlib:
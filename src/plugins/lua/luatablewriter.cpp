@@ -88,6 +88,53 @@ void LuaTableWriter::writeValue(const QByteArray &value)
     m_valueWritten = true;
 }
 
+/**
+ * Writes the given \a values, separated the same way as when calling
+ * writeValue() for each of them. The values are formatted in blocks, which
+ * is a lot faster for large amounts of values, like tile layer data.
+ */
+void LuaTableWriter::writeValues(const QVector<unsigned> &values)
+{
+    if (values.isEmpty())
+        return;
+
+    prepareNewValue();
+
+    // Each value takes at most 10 digits, plus up to 2 separator characters
+    char buffer[4096];
+    char *out = buffer;
+    char * const flushThreshold = buffer + sizeof(buffer) - 12;
+
+    for (int i = 0; i < values.size(); ++i) {
+        if (i > 0) {
+            *out++ = m_valueSeparator;
+            if (!m_minimize)
+                *out++ = ' ';
+        }
+
+        char digits[10];
+        int length = 0;
+        unsigned value = values.at(i);
+        do {
+            digits[length++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value);
+
+        while (length)
+            *out++ = digits[--length];
+
+        if (out >= flushThreshold) {
+            write(buffer, out - buffer);
+            out = buffer;
+        }
+    }
+
+    write(buffer, out - buffer);
+
+    m_newLine = false;
+    m_valueWritten = true;
+}
+
 void LuaTableWriter::writeUnquotedValue(const QByteArray &value)
 {
     prepareNewValue();
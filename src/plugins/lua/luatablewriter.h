@@ -23,6 +23,7 @@
 #include <QByteArray>
 #include <QString>
 #include <QVariant>
+#include <QVector>
 
 class QIODevice;
 
@@ -48,6 +49,7 @@ public:
     void writeValue(unsigned value);
     void writeValue(const QByteArray &value);
     void writeValue(const QString &value);
+    void writeValues(const QVector<unsigned> &values);
 
     void writeUnquotedValue(const QByteArray &value);
 
@@ -121,18 +121,15 @@ std::unique_ptr<Tiled::Map> ReplicaIslandPlugin::read(const QString &fileName)
             mError = tr("File ended in middle of layer!");
             return nullptr;
         }
-        quint8 *tp = reinterpret_cast<quint8 *>(tileData.data());
-
-        // Add the tiles to our layer.
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                quint8 tile_id = *tp++;
-                if (tile_id != 255) {
-                    Tile *tile = tileset->findTile(tile_id);
-                    layer->setCell(x, y, Cell(tile));
-                }
-            }
-        }
+
+        // Add the tiles to our layer. A tile ID of 255 means no tile.
+        QVector<Cell> cells(255);
+        for (int tileId = 0; tileId < cells.size(); ++tileId)
+            cells[tileId] = Cell(tileset->findTile(tileId));
+
+        layer->setCellsFromGrid(QRect(0, 0, width, height),
+                                reinterpret_cast<const quint8*>(tileData.constData()),
+                                cells);
     }
 
     // Make sure we read the entire *.bin file.
@@ -222,7 +219,16 @@ bool ReplicaIslandPlugin::supportsFile(const QString &fileName) const
         return false;
     char signature;
     qint64 read = f.read(&signature, 1);
-    return (read == 1 || signature == 96);
+    return (read == 1 && signature == 96);
+}
+
+bool ReplicaIslandPlugin::supportsFileHeader(const QString &fileName,
+                                             const QByteArray &header) const
+{
+    if (!fileName.endsWith(QLatin1String(".bin"), Qt::CaseInsensitive))
+        return false;
+
+    return header.startsWith(char(96));
 }
 
 QString ReplicaIslandPlugin::errorString() const
@@ -305,13 +311,13 @@ bool ReplicaIslandPlugin::writeLayer(QDataStream &out, Tiled::TileLayer *layer)
     // Write out the raw tile data.  We assume that the user has used the
     // correct tileset for this layer.
     for (int y = 0; y < layer->height(); y++) {
-        for (int x = 0; x < layer->width(); x++) {
-            Tile *tile = layer->cellAt(x, y).tile();
+        layer->forEachCellInRow(y, 0, layer->width(), [&] (int, const Cell &cell) {
+            Tile *tile = cell.tile();
             if (tile)
                 out << static_cast<quint8>(tile->id());
             else
                 out << static_cast<quint8>(255);
-        }
+        });
     }
 
     return true;
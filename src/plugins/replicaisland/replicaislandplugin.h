@@ -55,6 +55,8 @@ public:
     QString nameFilter() const override;
     QString shortName() const override;
     bool supportsFile(const QString &fileName) const override;
+    bool supportsFileHeader(const QString &fileName,
+                            const QByteArray &header) const override;
     QString errorString() const override;
     bool write(const Tiled::Map *map, const QString &fileName, Options options) override;
 
@@ -288,8 +288,7 @@ bool TbinMapFormat::write(const Tiled::Map *map, const QString &fileName, Option
                 tlayer.tileSize.y = map->tileHeight();
                 //tlayer.visible = ???;
                 for (int iy = 0; iy < tlayer.layerSize.y; ++iy) {
-                    for (int ix = 0; ix < tlayer.layerSize.x; ++ix) {
-                        Tiled::Cell cell = layer->cellAt(ix, iy);
+                    layer->forEachCellInRow(iy, 0, tlayer.layerSize.x, [&] (int ix, const Tiled::Cell &cell) {
                         tbin::Tile ttile;
                         ttile.staticData.tileIndex = -1;
 
@@ -322,7 +321,7 @@ bool TbinMapFormat::write(const Tiled::Map *map, const QString &fileName, Option
                             }
                         }
                         tlayer.tiles.push_back(ttile);
-                    }
+                    });
                 }
                 tiledToTbinProperties(layer->properties(), tlayer.props);
                 tmap.layers.push_back(std::move(tlayer));
@@ -416,6 +415,13 @@ bool TbinMapFormat::supportsFile(const QString &fileName) const
     return magic == "tBIN10";
 }
 
+bool TbinMapFormat::supportsFileHeader(const QString &fileName,
+                                       const QByteArray &header) const
+{
+    Q_UNUSED(fileName)
+    return header.startsWith("tBIN10");
+}
+
 QString TbinMapFormat::errorString() const
 {
     return mError;
@@ -54,6 +54,8 @@ public:
 
     std::unique_ptr<Tiled::Map> read(const QString &fileName) override;
     bool supportsFile(const QString &fileName) const override;
+    bool supportsFileHeader(const QString &fileName,
+                            const QByteArray &header) const override;
 
     bool write(const Tiled::Map *map, const QString &fileName, Options options) override;
 
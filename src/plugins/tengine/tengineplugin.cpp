@@ -35,6 +35,10 @@
 
 #include <QtMath>
 
+#include <algorithm>
+
+#include "qtcompat_p.h"
+
 using namespace Tengine;
 
 TenginePlugin::TenginePlugin()
@@ -77,70 +81,161 @@ bool TenginePlugin::write(const Tiled::Map *map, const QString &fileName, Option
     char asciiDisplay = ASCII_MIN;
     int overflowDisplay = 1;
     QHash<QString, Tiled::Properties>::const_iterator i;
+
+    // The display strings of the cached tiles, by the signature of their
+    // other properties, to avoid searching through all cached tiles
+    QHash<QString, QStringList> displaysBySignature;
+
+    auto signature = [] (const Properties &properties) {
+        QString signature;
+        for (auto it = properties.begin(), it_end = properties.end(); it != it_end; ++it) {
+            if (it.key() == QLatin1String("display"))
+                continue;
+            signature += it.key();
+            signature += QChar();
+            signature += it.value().toString();
+            signature += QChar();
+        }
+        return signature;
+    };
+
+    auto cacheTile = [&] (const QString &displayString, const Properties &tile) {
+        cachedTiles[displayString] = tile;
+        displaysBySignature[signature(tile)].append(displayString);
+    };
+
     // Add the empty tile
     int numEmptyTiles = 0;
     Properties emptyTile;
     emptyTile["display"] = "?";
-    cachedTiles["?"] = emptyTile;
-    // Process the map, collecting used display strings as we go
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            Properties currentTile = cachedTiles["?"];
-            for (Layer *layer : map->layers()) {
-                // If the layer name does not start with one of the tile properties, skip it
-                QString layerKey;
-                QListIterator<QString> propertyIterator = propertyOrder;
-                while (propertyIterator.hasNext()) {
-                    QString currentProperty = propertyIterator.next();
-                    if (layer->name().startsWith(currentProperty, Qt::CaseInsensitive)) {
-                        layerKey = currentProperty;
-                        break;
+    cacheTile(QStringLiteral("?"), emptyTile);
+
+    // Determine once which layers contribute to the tiles, based on whether
+    // their name starts with one of the tile properties
+    struct PropertyLayer
+    {
+        const TileLayer *tileLayer;
+        QString key;
+
+        // For tile layers, the tiles of the row being processed
+        QVector<Tile*> rowTiles;
+
+        // For object layers, the display and value set by each object and
+        // for each cell, the index of the last object setting them (or -1)
+        QVector<QVariant> displays;
+        QVector<QVariant> values;
+        QVector<int> displayGrid;
+        QVector<int> valueGrid;
+    };
+
+    QVector<PropertyLayer> propertyLayers;
+
+    for (Layer *layer : map->layers()) {
+        QString layerKey;
+        for (const QString &currentProperty : qAsConst(propertyOrder)) {
+            if (layer->name().startsWith(currentProperty, Qt::CaseInsensitive)) {
+                layerKey = currentProperty;
+                break;
+            }
+        }
+
+        if (layerKey.isEmpty())
+            continue;
+
+        PropertyLayer propertyLayer;
+        propertyLayer.tileLayer = layer->asTileLayer();
+        propertyLayer.key = layerKey;
+
+        if (ObjectGroup *objectLayer = layer->asObjectGroup()) {
+            // Rasterize the objects up front, so that each cell doesn't
+            // need to check all objects
+            propertyLayer.displayGrid.fill(-1, width * height);
+            propertyLayer.valueGrid.fill(-1, width * height);
+
+            for (const MapObject *obj : objectLayer->objects()) {
+                // Check the Object Layer properties if either display or value was missing
+                QVariant display = obj->property("display");
+                if (display.isNull())
+                    display = objectLayer->property("display");
+                QVariant value = obj->property("value");
+                if (value.isNull())
+                    value = objectLayer->property("value");
+
+                if (display.isNull() && value.isNull())
+                    continue;
+
+                const int index = propertyLayer.displays.size();
+                propertyLayer.displays.append(display);
+                propertyLayer.values.append(value);
+
+                const int startX = std::max(0, qFloor(obj->x()));
+                const int startY = std::max(0, qFloor(obj->y()));
+                const int endX = std::min(width - 1, qFloor(obj->x() + obj->width()));
+                const int endY = std::min(height - 1, qFloor(obj->y() + obj->height()));
+
+                for (int y = startY; y <= endY; ++y) {
+                    for (int x = startX; x <= endX; ++x) {
+                        if (!display.isNull())
+                            propertyLayer.displayGrid[x + y * width] = index;
+                        if (!value.isNull())
+                            propertyLayer.valueGrid[x + y * width] = index;
                     }
                 }
+            }
+        } else if (!propertyLayer.tileLayer) {
+            continue;
+        }
 
-                if (layerKey.isEmpty())
-                    continue;
+        propertyLayers.append(propertyLayer);
+    }
+
+    asciiMap.reserve(width * height);
 
+    // Process the map, collecting used display strings as we go
+    for (int y = 0; y < height; ++y) {
+        for (PropertyLayer &propertyLayer : propertyLayers) {
+            if (const TileLayer *tileLayer = propertyLayer.tileLayer) {
+                propertyLayer.rowTiles.resize(width);
+                tileLayer->forEachCellInRow(y, 0, width, [&] (int x, const Cell &cell) {
+                    propertyLayer.rowTiles[x] = cell.tile();
+                });
+            }
+        }
+
+        for (int x = 0; x < width; ++x) {
+            Properties currentTile = emptyTile;
+            for (const PropertyLayer &propertyLayer : qAsConst(propertyLayers)) {
                 // Process the Tile Layer
-                if (TileLayer *tileLayer = layer->asTileLayer()) {
-                    if (Tile *tile = tileLayer->cellAt(x, y).tile()) {
+                if (propertyLayer.tileLayer) {
+                    if (Tile *tile = propertyLayer.rowTiles.at(x)) {
                         currentTile["display"] = tile->property("display");
-                        currentTile[layerKey] = tile->property("value");
+                        currentTile[propertyLayer.key] = tile->property("value");
                     }
                 // Process the Object Layer
-                } else if (ObjectGroup *objectLayer = layer->asObjectGroup()) {
-                    for (const MapObject *obj : objectLayer->objects()) {
-                        if (floor(obj->y()) <= y && y <= floor(obj->y() + obj->height())) {
-                            if (floor(obj->x()) <= x && x <= floor(obj->x() + obj->width())) {
-                                // Check the Object Layer properties if either display or value was missing
-                                if (!obj->property("display").isNull()) {
-                                    currentTile["display"] = obj->property("display");
-                                } else if (!objectLayer->property("display").isNull()) {
-                                    currentTile["display"] = objectLayer->property("display");
-                                }
-                                if (!obj->property("value").isNull()) {
-                                    currentTile[layerKey] = obj->property("value");
-                                } else if (!objectLayer->property("value").isNull()) {
-                                    currentTile[layerKey] = objectLayer->property("value");
-                                }
-                            }
-                        }
-                    }
+                } else {
+                    const int displayIndex = propertyLayer.displayGrid.at(x + y * width);
+                    if (displayIndex != -1)
+                        currentTile["display"] = propertyLayer.displays.at(displayIndex);
+
+                    const int valueIndex = propertyLayer.valueGrid.at(x + y * width);
+                    if (valueIndex != -1)
+                        currentTile[propertyLayer.key] = propertyLayer.values.at(valueIndex);
                 }
             }
             // If the currentTile does not exist in the cache, add it
             if (!cachedTiles.contains(currentTile["display"].toString())) {
-                cachedTiles[currentTile["display"].toString()] = currentTile;
+                cacheTile(currentTile["display"].toString(), currentTile);
             // Otherwise check that it EXACTLY matches the cached one
             // and if not...
             } else if (currentTile != cachedTiles[currentTile["display"].toString()]) {
-                // Search the cached tiles for a match
+                // Search the cached tiles with the same properties for a match
                 bool foundInCache = false;
                 QString displayString;
-                for (i = cachedTiles.constBegin(); i != cachedTiles.constEnd(); ++i) {
-                    displayString = i.key();
+                const QStringList candidates = displaysBySignature.value(signature(currentTile));
+                for (const QString &candidate : candidates) {
+                    displayString = candidate;
                     currentTile["display"].setValue(displayString);
-                    if (currentTile == i.value()) {
+                    if (currentTile == cachedTiles.value(candidate)) {
                         foundInCache = true;
                         break;
                     }
@@ -160,7 +255,7 @@ bool TenginePlugin::write(const Tiled::Map *map, const QString &fileName, Option
                         }
                         currentTile["display"] = displayString;
                         if (!cachedTiles.contains(displayString)) {
-                            cachedTiles[displayString] = currentTile;
+                            cacheTile(displayString, currentTile);
                             break;
                         } else if (currentTile == cachedTiles[currentTile["display"].toString()]) {
                             break;
@@ -9,6 +9,7 @@ SUBDIRS = \
     plugins \
     tmxviewer \
     tmxrasterizer \
+    tmxdiff \
     terraingenerator
 
 tiled_quick {
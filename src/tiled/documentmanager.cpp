@@ -639,9 +639,10 @@ DocumentPtr DocumentManager::loadDocument(const QString &fileName,
 
     if (!fileFormat) {
         // Try to find a plugin that implements support for this format
+        const QByteArray header = FileFormat::readFileHeader(fileName);
         const auto formats = PluginManager::objects<FileFormat>();
         for (FileFormat *format : formats) {
-            if (format->supportsFile(fileName)) {
+            if (format->supportsFileHeader(fileName, header)) {
                 fileFormat = format;
                 break;
             }
@@ -31,6 +31,7 @@
 #include "editablelayer.h"
 #include "editablemanager.h"
 #include "editablemapobject.h"
+#include "editabletile.h"
 #include "editableobjectgroup.h"
 #include "editableselectedarea.h"
 #include "editabletilelayer.h"
@@ -39,10 +40,12 @@
 #include "mapobject.h"
 #include "maprenderer.h"
 #include "objectgroup.h"
+#include "remaptiles.h"
 #include "replacetileset.h"
 #include "resizemap.h"
 #include "scriptmanager.h"
 #include "tilelayer.h"
+#include "tileremapping.h"
 #include "tileset.h"
 #include "tilesetdocument.h"
 
@@ -316,6 +319,70 @@ QList<QObject *> EditableMap::usedTilesets() const
     return editableTilesets;
 }
 
+/**
+ * Returns how many times each tile of the given tileset is used by this map,
+ * in the order of EditableTileset::tiles().
+ */
+QList<int> EditableMap::tileUsage(EditableTileset *editableTileset) const
+{
+    if (!editableTileset) {
+        ScriptManager::instance().throwNullArgError(0);
+        return QList<int>();
+    }
+
+    const auto usage = map()->tileUsage();
+
+    QList<int> counts;
+    for (const Tile *tile : editableTileset->tileset()->tiles())
+        counts.append(usage.value(tile));
+    return counts;
+}
+
+/**
+ * Replaces each of the \a oldTiles with the tile at the same index in
+ * \a newTiles, on all layers in a single step. Flipping flags are preserved.
+ * A null entry in \a newTiles removes the tile.
+ */
+void EditableMap::replaceTiles(const QList<QObject *> &oldTiles,
+                               const QList<QObject *> &newTiles)
+{
+    if (oldTiles.size() != newTiles.size()) {
+        ScriptManager::instance().throwError(QCoreApplication::translate("Script Errors", "Lists of tiles must have the same length"));
+        return;
+    }
+
+    TileRemapping remapping;
+
+    for (int i = 0; i < oldTiles.size(); ++i) {
+        auto oldTile = qobject_cast<EditableTile*>(oldTiles.at(i));
+        auto newTile = qobject_cast<EditableTile*>(newTiles.at(i));
+        if (!oldTile || (newTiles.at(i) && !newTile)) {
+            ScriptManager::instance().throwError(QCoreApplication::translate("Script Errors", "Not a tile"));
+            return;
+        }
+        if (newTile && !map()->tilesets().contains(newTile->tile()->sharedTileset())) {
+            ScriptManager::instance().throwError(QCoreApplication::translate("Script Errors", "Tileset not part of the map"));
+            return;
+        }
+
+        remapping.insert(oldTile->tile(), newTile ? newTile->tile() : nullptr);
+    }
+
+    if (auto doc = mapDocument()) {
+        push(new RemapTiles(doc, remapping));
+    } else if (!checkReadOnly()) {
+        LayerIterator iterator(map());
+        while (Layer *layer = iterator.next()) {
+            if (TileLayer *tileLayer = layer->asTileLayer()) {
+                remapping.apply(*tileLayer);
+            } else if (ObjectGroup *objectGroup = layer->asObjectGroup()) {
+                for (MapObject *mapObject : *objectGroup)
+                    mapObject->setCell(remapping.map(mapObject->cell()));
+            }
+        }
+    }
+}
+
 /**
  * Merges the given map with this map. Automatically adds any tilesets that are
  * used by the merged map which are not yet part of this map.
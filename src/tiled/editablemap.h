@@ -142,6 +142,9 @@ public:
                                     Tiled::EditableTileset *newEditableTileset);
     Q_INVOKABLE bool removeTileset(Tiled::EditableTileset *editableTileset);
     Q_INVOKABLE QList<QObject *> usedTilesets() const;
+    Q_INVOKABLE QList<int> tileUsage(Tiled::EditableTileset *editableTileset) const;
+    Q_INVOKABLE void replaceTiles(const QList<QObject*> &oldTiles,
+                                  const QList<QObject*> &newTiles);
 
     Q_INVOKABLE void merge(Tiled::EditableMap *editableMap, bool canJoin = false);
 
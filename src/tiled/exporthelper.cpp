@@ -135,13 +135,8 @@ void ExportHelper::resolveTypeAndProperties(MapObject *object) const
     Properties properties;
 
     // Inherit properties from type
-    if (!object->type().isEmpty()) {
-        for (int i = Object::objectTypes().size() - 1; i >= 0; --i) {
-            auto const &type = Object::objectTypes().at(i);
-            if (type.name == object->type())
-                mergeProperties(properties, type.defaultProperties);
-        }
-    }
+    if (!object->type().isEmpty())
+        mergeProperties(properties, Object::objectTypeProperties(object->type()));
 
     // Inherit properties from tile
     if (tile)
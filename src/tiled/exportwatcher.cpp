@@ -0,0 +1,441 @@
+/*
+ * exportwatcher.cpp
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "exportwatcher.h"
+
+#include "map.h"
+#include "mapformat.h"
+#include "mapobject.h"
+#include "objecttemplate.h"
+#include "objecttemplateformat.h"
+#include "templatemanager.h"
+#include "utils.h"
+
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QJsonDocument>
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+
+namespace Tiled {
+
+ExportWatcher::ExportWatcher(MapFormat *format,
+                             const QString &sourceDirectory,
+                             const QString &targetDirectory,
+                             Preferences::ExportOptions options,
+                             QObject *parent)
+    : QObject(parent)
+    , mFormat(format)
+    , mSourceDir(QDir(sourceDirectory).absolutePath())
+    , mTargetDir(QDir(targetDirectory).absolutePath())
+    , mTargetExtension(Utils::firstExtension(format->nameFilter()))
+    , mOptions(options)
+    , mExportHelper(options)
+{
+    // The watcher reports changed paths only after they have been quiet for
+    // a moment, which avoids exporting a map while it is still being saved.
+    connect(&mWatcher, &FileSystemWatcher::pathsChanged,
+            this, &ExportWatcher::pathsChanged);
+    connect(Preferences::instance(), &Preferences::objectTypesChanged,
+            this, &ExportWatcher::objectTypesChanged);
+}
+
+/**
+ * Exports all maps found in the source directory and starts watching for
+ * changes.
+ */
+void ExportWatcher::start()
+{
+    QJsonObject object;
+    object.insert(QLatin1String("source"), mSourceDir.absolutePath());
+    object.insert(QLatin1String("target"), mTargetDir.absolutePath());
+    object.insert(QLatin1String("format"), mFormat->shortName());
+    log(QLatin1String("started"), object);
+
+    scanDirectory(mSourceDir.absolutePath());
+    exportPendingMaps();
+}
+
+/**
+ * Watches the given directory and looks for maps that were added to it or
+ * removed from it. New subdirectories are scanned recursively.
+ */
+void ExportWatcher::scanDirectory(const QString &path)
+{
+    if (!mDirectories.contains(path)) {
+        mDirectories.insert(path);
+        mWatcher.addPath(path);
+    }
+
+    const QDir dir(path);
+    const auto entries = dir.entryInfoList(QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot);
+    for (const QFileInfo &fileInfo : entries) {
+        const QString filePath = fileInfo.absoluteFilePath();
+
+        if (fileInfo.isDir()) {
+            // Symbolic links are skipped to avoid getting caught in a loop
+            if (!fileInfo.isSymLink() &&
+                    !mDirectories.contains(filePath) &&
+                    !isInTargetDirectory(filePath)) {
+                scanDirectory(filePath);
+            }
+        } else if (!mMaps.contains(filePath) && findSupportingMapFormat(filePath)) {
+            addMap(filePath);
+        }
+    }
+
+    const auto maps = mMaps;
+    for (const QString &fileName : maps)
+        if (QFileInfo(fileName).absolutePath() == path && !QFile::exists(fileName))
+            removeMap(fileName);
+}
+
+void ExportWatcher::removeDirectory(const QString &path)
+{
+    const QString prefix = path + QLatin1Char('/');
+
+    const auto directories = mDirectories;
+    for (const QString &directory : directories) {
+        if (directory == path || directory.startsWith(prefix)) {
+            mDirectories.remove(directory);
+            mWatcher.removePath(directory);
+        }
+    }
+
+    const auto maps = mMaps;
+    for (const QString &fileName : maps)
+        if (fileName.startsWith(prefix))
+            removeMap(fileName);
+}
+
+void ExportWatcher::addMap(const QString &fileName)
+{
+    mMaps.insert(fileName);
+    mPendingMaps.insert(fileName);
+    mWatcher.addPath(fileName);
+}
+
+/**
+ * Stops watching a map that was removed. Its exported copy is left alone.
+ */
+void ExportWatcher::removeMap(const QString &fileName)
+{
+    mMaps.remove(fileName);
+    mPendingMaps.remove(fileName);
+    mWatcher.removePath(fileName);
+
+    const QStringList dependencies = watchedDependencies(fileName);
+    mIndex.remove(fileName);
+    unwatchDependencies(dependencies);
+
+    QJsonObject object;
+    object.insert(QLatin1String("source"), mSourceDir.relativeFilePath(fileName));
+    log(QLatin1String("removed"), object);
+}
+
+/**
+ * Indexes the given map again, along with the templates it refers to that
+ * were not indexed yet, and watches the tilesets and templates it uses.
+ */
+void ExportWatcher::indexMap(const QString &fileName)
+{
+    const QStringList oldDependencies = watchedDependencies(fileName);
+    mIndex.update(QStringList { fileName });
+
+    QStringList newTemplates;
+    for (const DependencyIndex::Dependency &dependency : mIndex.dependencies(fileName)) {
+        if (dependency.type == DependencyIndex::TemplateReference &&
+                !mTemplates.contains(dependency.fileName)) {
+            mTemplates.insert(dependency.fileName);
+            newTemplates.append(dependency.fileName);
+        }
+    }
+    mIndex.update(newTemplates);
+
+    // Files still used are added before being removed, so they stay watched
+    const QStringList newDependencies = watchedDependencies(fileName);
+    for (const QString &dependency : newDependencies)
+        mWatcher.addPath(dependency);
+
+    unwatchDependencies(oldDependencies);
+}
+
+/**
+ * Indexes the given template again, and updates the files watched for the
+ * maps using it, since the template may refer to another tileset now.
+ */
+void ExportWatcher::indexTemplate(const QString &fileName)
+{
+    const QStringList maps = mapsUsing(fileName);
+
+    QVector<QStringList> oldDependencies;
+    for (const QString &map : maps)
+        oldDependencies.append(watchedDependencies(map));
+
+    mIndex.update(QStringList { fileName });
+
+    for (const QString &map : maps) {
+        const QStringList newDependencies = watchedDependencies(map);
+        for (const QString &dependency : newDependencies)
+            mWatcher.addPath(dependency);
+    }
+
+    for (const QStringList &dependencies : qAsConst(oldDependencies))
+        unwatchDependencies(dependencies);
+}
+
+/**
+ * Returns the tilesets and templates the given map refers to, as well as
+ * the tilesets used by those templates, according to the index.
+ */
+QStringList ExportWatcher::watchedDependencies(const QString &fileName) const
+{
+    QStringList fileNames;
+    for (const DependencyIndex::Dependency &dependency : mIndex.dependencies(fileName)) {
+        if (dependency.type == DependencyIndex::ImageReference)
+            continue;
+
+        fileNames.append(dependency.fileName);
+
+        if (dependency.type == DependencyIndex::TemplateReference) {
+            for (const DependencyIndex::Dependency &templateDependency : mIndex.dependencies(dependency.fileName))
+                if (templateDependency.type == DependencyIndex::TilesetReference)
+                    fileNames.append(templateDependency.fileName);
+        }
+    }
+
+    // Each file is watched only once per map
+    fileNames.removeDuplicates();
+    return fileNames;
+}
+
+/**
+ * Stops watching the given files for one map. Tilesets and templates no
+ * longer used by any map are released.
+ */
+void ExportWatcher::unwatchDependencies(const QStringList &dependencies)
+{
+    for (const QString &dependency : dependencies) {
+        mWatcher.removePath(dependency);
+
+        if (mapsUsing(dependency).isEmpty()) {
+            mTilesets.remove(dependency);
+
+            if (mTemplates.remove(dependency))
+                mIndex.remove(dependency);
+        }
+    }
+}
+
+/**
+ * Returns the maps using the given file, either directly or through a
+ * template.
+ */
+QStringList ExportWatcher::mapsUsing(const QString &fileName) const
+{
+    QStringList maps = mIndex.usages(fileName);
+    maps.erase(std::remove_if(maps.begin(), maps.end(), [this] (const QString &usage) {
+        return !mMaps.contains(usage);
+    }), maps.end());
+    return maps;
+}
+
+void ExportWatcher::pathsChanged(const QStringList &paths)
+{
+    QSet<QString> changedTemplates;
+
+    for (const QString &path : paths) {
+        if (mDirectories.contains(path)) {
+            if (QFileInfo(path).isDir())
+                scanDirectory(path);
+            else
+                removeDirectory(path);
+        }
+
+        if (mMaps.contains(path)) {
+            if (QFile::exists(path))
+                mPendingMaps.insert(path);
+            else
+                removeMap(path);
+        }
+
+        // Drop a changed tileset from the cache so that it is loaded again
+        // by the next map using it. The templates using it are read again
+        // as well, since they also hold on to it.
+        const QStringList dependentMaps = mapsUsing(path);
+        if (!dependentMaps.isEmpty()) {
+            mTilesets.remove(path);
+
+            if (mTemplates.contains(path)) {
+                indexTemplate(path);
+                changedTemplates.insert(path);
+            }
+
+            for (const QString &fileName : mIndex.dependents(path))
+                if (mTemplates.contains(fileName))
+                    changedTemplates.insert(fileName);
+
+            for (const QString &fileName : dependentMaps)
+                mPendingMaps.insert(fileName);
+        }
+    }
+
+    for (const QString &fileName : qAsConst(changedTemplates))
+        reloadTemplate(fileName);
+
+    exportPendingMaps();
+}
+
+/**
+ * Reads the given template again. The TemplateManager reloads templates
+ * as soon as they change, which may be while they are still being saved,
+ * so this is done again once the changes have settled.
+ *
+ * The tileset of the template is released first, so that a changed tileset
+ * is read again as well. A template that fails to load is left empty, like
+ * for a broken reference.
+ */
+void ExportWatcher::reloadTemplate(const QString &fileName)
+{
+    ObjectTemplate *objectTemplate = TemplateManager::instance()->findObjectTemplate(fileName);
+    if (!objectTemplate)
+        return;
+
+    objectTemplate->setObject(static_cast<const MapObject*>(nullptr));
+
+    if (const auto newTemplate = readObjectTemplate(fileName))
+        objectTemplate->setObject(newTemplate->object());
+}
+
+void ExportWatcher::objectTypesChanged()
+{
+    // Object types only affect the output when they are being resolved
+    if (!mOptions.testFlag(Preferences::ResolveObjectTypesAndProperties))
+        return;
+
+    mPendingMaps = mMaps;
+    exportPendingMaps();
+}
+
+void ExportWatcher::exportPendingMaps()
+{
+    if (mPendingMaps.isEmpty())
+        return;
+
+    QStringList fileNames = mPendingMaps.values();
+    std::sort(fileNames.begin(), fileNames.end());
+    mPendingMaps.clear();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    int failed = 0;
+    for (const QString &fileName : qAsConst(fileNames))
+        if (!exportMap(fileName))
+            ++failed;
+
+    QJsonObject object;
+    object.insert(QLatin1String("exported"), fileNames.size() - failed);
+    object.insert(QLatin1String("failed"), failed);
+    object.insert(QLatin1String("ms"), timer.elapsed());
+    log(QLatin1String("idle"), object);
+}
+
+bool ExportWatcher::exportMap(const QString &fileName)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QJsonObject object;
+    object.insert(QLatin1String("source"), mSourceDir.relativeFilePath(fileName));
+
+    // Watch the files this map depends on, also when it fails to load
+    indexMap(fileName);
+
+    QString error;
+    const std::unique_ptr<Map> map(readMap(fileName, &error));
+    if (!map) {
+        object.insert(QLatin1String("error"), error);
+        log(QLatin1String("failed"), object);
+        return false;
+    }
+
+    // Keep the watched tilesets loaded for the next export. Tilesets used
+    // through templates are kept loaded by their templates.
+    const QStringList dependencies = watchedDependencies(fileName);
+    for (const SharedTileset &tileset : map->tilesets())
+        if (tileset->isExternal() && dependencies.contains(tileset->fileName()))
+            mTilesets.insert(tileset->fileName(), tileset);
+
+    std::unique_ptr<Map> exportMap;
+    const Map *preparedMap = mExportHelper.prepareExportMap(map.get(), exportMap);
+
+    const QString targetFile = targetFileName(fileName);
+    object.insert(QLatin1String("target"), mTargetDir.relativeFilePath(targetFile));
+
+    if (!QDir().mkpath(QFileInfo(targetFile).absolutePath()) ||
+            !mFormat->write(preparedMap, targetFile, mExportHelper.formatOptions())) {
+        object.insert(QLatin1String("error"), mFormat->errorString());
+        log(QLatin1String("failed"), object);
+        return false;
+    }
+
+    object.insert(QLatin1String("ms"), timer.elapsed());
+    log(QLatin1String("exported"), object);
+    return true;
+}
+
+bool ExportWatcher::isInTargetDirectory(const QString &path) const
+{
+    const QString targetPath = mTargetDir.absolutePath();
+    return path == targetPath || path.startsWith(targetPath + QLatin1Char('/'));
+}
+
+/**
+ * Returns the file name the given map is exported to, which has the same
+ * path relative to the target directory as the map has relative to the
+ * source directory.
+ */
+QString ExportWatcher::targetFileName(const QString &fileName) const
+{
+    const QFileInfo relative(mSourceDir.relativeFilePath(fileName));
+    if (mTargetExtension.isEmpty())
+        return mTargetDir.filePath(relative.filePath());
+
+    return mTargetDir.filePath(relative.path() + QLatin1Char('/') +
+                               relative.completeBaseName() + mTargetExtension);
+}
+
+/**
+ * Writes a single line with a compact JSON object describing the event to
+ * the standard output.
+ */
+void ExportWatcher::log(const QString &event, QJsonObject object) const
+{
+    object.insert(QLatin1String("event"), event);
+
+    const QByteArray line = QJsonDocument(object).toJson(QJsonDocument::Compact);
+    std::fprintf(stdout, "%s\n", line.constData());
+    std::fflush(stdout);
+}
+
+} // namespace Tiled
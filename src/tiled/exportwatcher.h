@@ -0,0 +1,101 @@
+/*
+ * exportwatcher.h
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "dependencyindex.h"
+#include "exporthelper.h"
+#include "filesystemwatcher.h"
+#include "preferences.h"
+#include "tileset.h"
+
+#include <QDir>
+#include <QHash>
+#include <QJsonObject>
+#include <QObject>
+#include <QSet>
+
+namespace Tiled {
+
+class MapFormat;
+
+/**
+ * Watches a directory for maps and keeps an exported copy of each map up to
+ * date in a target directory.
+ *
+ * External tilesets stay loaded between exports, and a map is only exported
+ * again when it or one of the tilesets or templates it depends on changed.
+ * The dependencies are looked up in a DependencyIndex of the maps and the
+ * templates they use, so they are only known for the TMX and JSON formats.
+ * Progress is written to the standard output, as one JSON object per line.
+ */
+class ExportWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    ExportWatcher(MapFormat *format,
+                  const QString &sourceDirectory,
+                  const QString &targetDirectory,
+                  Preferences::ExportOptions options,
+                  QObject *parent = nullptr);
+
+    void start();
+
+private:
+    void scanDirectory(const QString &path);
+    void removeDirectory(const QString &path);
+    void addMap(const QString &fileName);
+    void removeMap(const QString &fileName);
+    void indexMap(const QString &fileName);
+    void indexTemplate(const QString &fileName);
+    QStringList watchedDependencies(const QString &fileName) const;
+    void unwatchDependencies(const QStringList &dependencies);
+    QStringList mapsUsing(const QString &fileName) const;
+
+    void pathsChanged(const QStringList &paths);
+    void reloadTemplate(const QString &fileName);
+    void objectTypesChanged();
+
+    void exportPendingMaps();
+    bool exportMap(const QString &fileName);
+
+    bool isInTargetDirectory(const QString &path) const;
+    QString targetFileName(const QString &fileName) const;
+    void log(const QString &event, QJsonObject object = QJsonObject()) const;
+
+    MapFormat *mFormat;
+    QDir mSourceDir;
+    QDir mTargetDir;
+    QString mTargetExtension;
+    const Preferences::ExportOptions mOptions;
+    const ExportHelper mExportHelper;
+
+    FileSystemWatcher mWatcher;
+    QSet<QString> mDirectories;
+    QSet<QString> mMaps;
+    QSet<QString> mPendingMaps;
+
+    DependencyIndex mIndex;     // of the maps and their templates
+    QSet<QString> mTemplates;   // the templates in the index
+    QHash<QString, SharedTileset> mTilesets;
+};
+
+} // namespace Tiled
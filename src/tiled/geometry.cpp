@@ -100,6 +100,10 @@ QVector<QPoint> pointsOnEllipse(int x0, int y0, int x1, int y1)
 
 /**
  * returns an elliptical region centered at x0,y0 with radius determinded by x1,y1
+ *
+ * The ellipse is rasterized into one span per row, from which the region is
+ * set up directly. Uniting the region from many small rectangles gets very
+ * slow for large ellipses.
  */
 QRegion ellipseRegion(int x0, int y0, int x1, int y1)
 {
@@ -115,6 +119,15 @@ QRegion ellipseRegion(int x0, int y0, int x1, int y1)
     if (radiusX == 0 && radiusY == 0)
         return ret;
 
+    // The half width of the span on each row, by distance from the center
+    QVector<int> halfWidths(radiusY + 1);
+    auto addSpan = [&halfWidths] (int halfWidth, int row) {
+        row = qAbs(row);
+        if (row >= halfWidths.size())
+            halfWidths.resize(row + 1);
+        halfWidths[row] = qMax(halfWidths[row], halfWidth);
+    };
+
     twoXSquare = 2 * radiusX * radiusX;
     twoYSquare = 2 * radiusY * radiusY;
     x = radiusX;
@@ -125,8 +138,7 @@ QRegion ellipseRegion(int x0, int y0, int x1, int y1)
     stoppingX = twoYSquare*radiusX;
     stoppingY = 0;
     while (stoppingX >= stoppingY) {
-        ret += QRect(-x, y, x * 2, 1);
-        ret += QRect(-x, -y, x * 2, 1);
+        addSpan(x, y);
         y++;
         stoppingY += twoXSquare;
         ellipseError += yChange;
@@ -146,8 +158,7 @@ QRegion ellipseRegion(int x0, int y0, int x1, int y1)
     stoppingX = 0;
     stoppingY = twoXSquare * radiusY;
     while (stoppingX <= stoppingY) {
-        ret += QRect(-x, y, x * 2, 1);
-        ret += QRect(-x, -y, x * 2, 1);
+        addSpan(x, y);
         x++;
         stoppingX += twoYSquare;
         ellipseError += xChange;
@@ -160,6 +171,27 @@ QRegion ellipseRegion(int x0, int y0, int x1, int y1)
         }
     }
 
+    // Set up the region from the spans, which are already sorted by row.
+    // Rows with the same span are combined, as expected by QRegion.
+    QVector<QRect> rects;
+    const int rows = halfWidths.size();
+    for (int row = 1 - rows; row < rows; ++row) {
+        const int halfWidth = halfWidths.at(qAbs(row));
+        if (halfWidth == 0)
+            continue;
+
+        if (!rects.isEmpty()) {
+            QRect &last = rects.last();
+            if (last.bottom() == row - 1 && last.left() == -halfWidth) {
+                last.setBottom(row);
+                continue;
+            }
+        }
+
+        rects.append(QRect(-halfWidth, row, halfWidth * 2, 1));
+    }
+
+    ret.setRects(rects.constData(), rects.size());
     return ret.translated(x0, y0);
 }
 
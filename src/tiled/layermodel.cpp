@@ -331,15 +331,11 @@ QModelIndex LayerModel::index(Layer *layer, int column) const
 
     Q_ASSERT(layer->map() == mMap);
 
-    if (auto parentLayer = layer->parentLayer()) {
-        int row = parentLayer->layers().indexOf(layer);
-        Q_ASSERT(row != -1);
-        return createIndex(row, column, parentLayer);
-    }
-
-    int row = mMap->layers().indexOf(layer);
+    // The sibling index is cached by the layer, so this doesn't need to
+    // search through the siblings
+    const int row = layer->siblingIndex();
     Q_ASSERT(row != -1);
-    return createIndex(row, column, nullptr);
+    return createIndex(row, column, layer->parentLayer());
 }
 
 Layer *LayerModel::toLayer(const QModelIndex &index) const
@@ -22,6 +22,7 @@
 
 #include "commandlineparser.h"
 #include "exporthelper.h"
+#include "exportwatcher.h"
 #include "languagemanager.h"
 #include "logginginterface.h"
 #include "mainwindow.h"
@@ -37,6 +38,7 @@
 #include "tmxmapformat.h"
 
 #include <QDebug>
+#include <QDir>
 #include <QFileInfo>
 #include <QJsonArray>
 #include <QJsonDocument>
@@ -71,6 +73,7 @@ public:
     bool disableOpenGL;
     bool exportMap;
     bool exportTileset;
+    bool watchExport;
     bool newInstance;
     Preferences::ExportOptions exportOptions;
 
@@ -80,6 +83,7 @@ private:
     void setDisableOpenGL();
     void setExportMap();
     void setExportTileset();
+    void setWatchExport();
     void setExportEmbedTilesets();
     void setExportDetachTemplateInstances();
     void setExportResolveObjectTypesAndProperties();
@@ -190,6 +194,7 @@ CommandLineHandler::CommandLineHandler()
     , disableOpenGL(false)
     , exportMap(false)
     , exportTileset(false)
+    , watchExport(false)
     , newInstance(false)
 {
     option<&CommandLineHandler::showVersion>(
@@ -217,6 +222,11 @@ CommandLineHandler::CommandLineHandler()
                 QLatin1String("--export-tileset"),
                 tr("Export the specified tileset file to target"));
 
+    option<&CommandLineHandler::setWatchExport>(
+                QChar(),
+                QLatin1String("--watch-export"),
+                tr("Export all maps in the specified directory to target, and again whenever they change"));
+
     option<&CommandLineHandler::showExportFormats>(
                 QChar(),
                 QLatin1String("--export-formats"),
@@ -278,6 +288,11 @@ void CommandLineHandler::setExportTileset()
     exportTileset = true;
 }
 
+void CommandLineHandler::setWatchExport()
+{
+    watchExport = true;
+}
+
 void CommandLineHandler::setExportEmbedTilesets()
 {
     exportOptions |= Preferences::EmbedTilesets;
@@ -470,6 +485,55 @@ int main(int argc, char *argv[])
         return 0;
     }
 
+    if (commandLine.watchExport) {
+        // Get the format, the source directory and the target directory
+        if (commandLine.exportMap || commandLine.exportTileset || commandLine.filesToOpen().length() != 3) {
+            qWarning().noquote() << QCoreApplication::translate("Command line", "Watch syntax is --watch-export <format> <source directory> <target directory>");
+            return 1;
+        }
+
+        initializePluginsAndExtensions();
+
+        const QString &filter = commandLine.filesToOpen().at(0);
+        const QString &sourceDirectory = commandLine.filesToOpen().at(1);
+        const QString &targetDirectory = commandLine.filesToOpen().at(2);
+
+        QString errorMsg;
+        MapFormat *outputFormat = findExportFormat<MapFormat>(&filter, QString(), errorMsg);
+        if (!outputFormat) {
+            Q_ASSERT(!errorMsg.isEmpty());
+            qWarning().noquote() << errorMsg;
+            return 1;
+        }
+
+        if (!QFileInfo(sourceDirectory).isDir()) {
+            qWarning().noquote() << QCoreApplication::translate("Command line", "Source directory does not exist.");
+            return 1;
+        }
+
+        // Exporting into the source directory would make the watcher pick up
+        // its own output, or overwrite the source maps
+        const QString sourcePath = QFileInfo(sourceDirectory).canonicalFilePath();
+        QString targetPath = QFileInfo(targetDirectory).canonicalFilePath();
+        if (targetPath.isEmpty())
+            targetPath = QDir::cleanPath(QFileInfo(targetDirectory).absoluteFilePath());
+
+        auto isInDirectory = [] (const QString &path, const QString &directory) {
+            return path == directory || path.startsWith(directory + QLatin1Char('/'));
+        };
+
+        if (isInDirectory(targetPath, sourcePath) || isInDirectory(sourcePath, targetPath)) {
+            qWarning().noquote() << QCoreApplication::translate("Command line", "Target directory may not overlap with the source directory.");
+            return 1;
+        }
+
+        ExportWatcher exportWatcher(outputFormat, sourceDirectory, targetDirectory,
+                                    commandLine.exportOptions);
+        exportWatcher.start();
+
+        return a.exec();
+    }
+
     if (!commandLine.filesToOpen().isEmpty() && !commandLine.newInstance) {
         // Convert files to absolute paths because the already running Tiled
         // instance likely does not have the same working directory.
@@ -109,6 +109,19 @@ MapDocument::MapDocument(std::unique_ptr<Map> map)
     connect(mMapObjectModel, &QAbstractItemModel::rowsMoved,
             this, &MapDocument::onObjectsMoved);
 
+    // Keep the object reference graph up to date. These connections are made
+    // first, so that the graph is updated before other parts of the UI react.
+    mObjectReferences.reset(mMap.get());
+
+    connect(this, &Document::propertyAdded,
+            this, &MapDocument::updateObjectReferences);
+    connect(this, &Document::propertyRemoved,
+            this, &MapDocument::updateObjectReferences);
+    connect(this, &Document::propertyChanged,
+            this, &MapDocument::updateObjectReferences);
+    connect(this, &Document::propertiesChanged,
+            this, &MapDocument::updateObjectReferences);
+
     connect(TemplateManager::instance(), &TemplateManager::objectTemplateChanged,
             this, &MapDocument::updateTemplateInstances);
 }
@@ -1161,9 +1174,14 @@ bool MapDocument::templateAllowed(const ObjectTemplate *objectTemplate) const
 void MapDocument::onChanged(const ChangeEvent &change)
 {
     switch (change.type) {
+    case ChangeEvent::MapObjectsAdded:
+        mObjectReferences.addObjects(static_cast<const MapObjectsEvent&>(change).mapObjects);
+        break;
     case ChangeEvent::MapObjectsAboutToBeRemoved: {
         const auto &mapObjects = static_cast<const MapObjectsEvent&>(change).mapObjects;
 
+        mObjectReferences.removeObjects(mapObjects);
+
         if (mHoveredMapObject && mapObjects.contains(mHoveredMapObject))
             setHoveredMapObject(nullptr);
 
@@ -1173,6 +1191,17 @@ void MapDocument::onChanged(const ChangeEvent &change)
 
         break;
     }
+    case ChangeEvent::MapObjectsChanged: {
+        // Commands like detaching or resetting template instances change the
+        // custom properties directly, without emitting the property signals
+        const auto &objectsChange = static_cast<const MapObjectsChangeEvent&>(change);
+        if (objectsChange.properties == MapObject::AllProperties ||
+                objectsChange.properties & (MapObject::CustomProperties | MapObject::TemplateProperty)) {
+            for (MapObject *mapObject : objectsChange.mapObjects)
+                mObjectReferences.updateReferences(mapObject);
+        }
+        break;
+    }
     default:
         break;
     }
@@ -1221,6 +1250,8 @@ void MapDocument::onObjectsMoved(const QModelIndex &parent, int start, int end,
 
 void MapDocument::onLayerAdded(Layer *layer)
 {
+    mObjectReferences.addLayer(layer);
+
     emit layerAdded(layer);
 
     // Select the first layer that gets added to the map
@@ -1259,6 +1290,8 @@ void MapDocument::onLayerAboutToBeRemoved(GroupLayer *groupLayer, int index)
     }
 
     emit layerAboutToBeRemoved(groupLayer, index);
+
+    mObjectReferences.removeLayer(layer);
 }
 
 void MapDocument::onLayerRemoved(Layer *layer)
@@ -1279,6 +1312,12 @@ void MapDocument::onLayerRemoved(Layer *layer)
     emit layerRemoved(layer);
 }
 
+void MapDocument::updateObjectReferences(Object *object)
+{
+    if (object->typeId() == Object::MapObjectType)
+        mObjectReferences.updateReferences(static_cast<MapObject*>(object));
+}
+
 void MapDocument::checkIssues()
 {
     // Clear any previously found issues in this document
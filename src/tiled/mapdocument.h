@@ -26,6 +26,7 @@
 #include "layer.h"
 #include "map.h"
 #include "mapformat.h"
+#include "objectreferencegraph.h"
 #include "tiled.h"
 #include "tileset.h"
 
@@ -199,6 +200,12 @@ public:
 
     MapObjectModel *mapObjectModel() const { return mMapObjectModel; }
 
+    /**
+     * Returns the graph of object references between the objects in this
+     * map. Also provides fast lookup of objects by ID.
+     */
+    const ObjectReferenceGraph &objectReferences() const { return mObjectReferences; }
+
     /**
      * Returns the map renderer.
      */
@@ -377,6 +384,8 @@ private:
     void onLayerAboutToBeRemoved(GroupLayer *groupLayer, int index);
     void onLayerRemoved(Layer *layer);
 
+    void updateObjectReferences(Object *object);
+
     void moveObjectIndex(const MapObject *object, int count);
 
     /*
@@ -394,6 +403,7 @@ private:
     std::unique_ptr<MapRenderer> mRenderer;
     Layer *mCurrentLayer = nullptr;
     MapObjectModel *mMapObjectModel;
+    ObjectReferenceGraph mObjectReferences;
     bool mAllowHidingObjects = true;
     bool mAllowTileObjects = true;
 };
@@ -229,6 +229,7 @@ void MapItem::setDisplayMode(DisplayMode displayMode)
 
         mObjectSelectionItem = std::make_unique<ObjectSelectionItem>(mapDocument(), this);
         mObjectSelectionItem->setZValue(10000 - 1);
+        mObjectSelectionItem->setViewRect(mViewRect);
     }
 
     updateSelectedLayersHighlight();
@@ -248,6 +249,17 @@ void MapItem::setShowTileCollisionShapes(bool enabled)
             item->update();
 }
 
+/**
+ * Sets the area visible in the view, in scene coordinates.
+ */
+void MapItem::setViewRect(const QRectF &viewRect)
+{
+    mViewRect = viewRect;
+
+    if (mObjectSelectionItem)
+        mObjectSelectionItem->setViewRect(viewRect);
+}
+
 QRectF MapItem::boundingRect() const
 {
     return mBoundingRect;
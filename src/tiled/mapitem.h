@@ -72,6 +72,7 @@ public:
 
     void setDisplayMode(DisplayMode displayMode);
     void setShowTileCollisionShapes(bool enabled);
+    void setViewRect(const QRectF &viewRect);
 
     // QGraphicsItem
     QRectF boundingRect() const override;
@@ -140,6 +141,7 @@ private:
     QMap<MapObject*, MapObjectItem*> mObjectItems;
     DisplayMode mDisplayMode;
     QRectF mBoundingRect;
+    QRectF mViewRect;
     bool mIsHovered = false;
 };
 
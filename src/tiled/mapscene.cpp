@@ -122,6 +122,21 @@ QRectF MapScene::mapBoundingRect() const
     return QRectF();
 }
 
+/**
+ * Sets the area visible in the view, in scene coordinates. Passed on to the
+ * map items, which use it to limit the creation of object reference items.
+ */
+void MapScene::setViewRect(const QRectF &viewRect)
+{
+    if (mViewRect == viewRect)
+        return;
+
+    mViewRect = viewRect;
+
+    for (MapItem *mapItem : qAsConst(mMapItems))
+        mapItem->setViewRect(viewRect);
+}
+
 /**
  * Sets the currently selected tool.
  */
@@ -200,6 +215,9 @@ void MapScene::refreshScene()
     mMapItems.swap(mapItems);
     qDeleteAll(mapItems);       // delete all map items that didn't get reused
 
+    for (MapItem *mapItem : qAsConst(mMapItems))
+        mapItem->setViewRect(mViewRect);
+
     updateSceneRect();
 
     const Map *map = mMapDocument->map();
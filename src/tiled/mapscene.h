@@ -64,6 +64,8 @@ public:
 
     QRectF mapBoundingRect() const;
 
+    void setViewRect(const QRectF &viewRect);
+
     void setSelectedTool(AbstractTool *tool);
 
     MapItem *mapItem(MapDocument *mapDocument) const;
@@ -111,6 +113,7 @@ private:
     Qt::KeyboardModifiers mCurrentModifiers = Qt::NoModifier;
     QPointF mLastMousePos;
     QColor mDefaultBackgroundColor;
+    QRectF mViewRect;
 };
 
 /**
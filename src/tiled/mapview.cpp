@@ -82,6 +82,11 @@ MapView::MapView(QWidget *parent, Mode mode)
     setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
 
     connect(mZoomable, &Zoomable::scaleChanged, this, &MapView::adjustScale);
+
+    connect(horizontalScrollBar(), &QAbstractSlider::valueChanged,
+            this, &MapView::updateViewRect);
+    connect(verticalScrollBar(), &QAbstractSlider::valueChanged,
+            this, &MapView::updateViewRect);
 }
 
 MapView::~MapView()
@@ -103,6 +108,7 @@ void MapView::setScene(MapScene *scene)
     }
 
     setMapDocument(scene ? scene->mapDocument() : nullptr);
+    updateViewRect();
 }
 
 MapScene *MapView::mapScene() const
@@ -158,6 +164,8 @@ void MapView::adjustScale(qreal scale)
 
     setRenderHint(QPainter::SmoothPixmapTransform,
                   mZoomable->smoothTransform());
+
+    updateViewRect();
 }
 
 void MapView::setUseOpenGL(bool useOpenGL)
@@ -187,6 +195,15 @@ void MapView::setUseOpenGL(bool useOpenGL)
 #endif
 }
 
+/**
+ * Informs the scene about the area that is currently visible.
+ */
+void MapView::updateViewRect()
+{
+    if (MapScene *scene = mapScene())
+        scene->setViewRect(mapToScene(viewport()->rect()).boundingRect());
+}
+
 void MapView::updateSceneRect(const QRectF &sceneRect)
 {
     updateSceneRect(sceneRect, transform());
@@ -338,6 +355,8 @@ void MapView::resizeEvent(QResizeEvent *event)
         updateSceneRect(s->sceneRect());
 
     QGraphicsView::resizeEvent(event);
+
+    updateViewRect();
 }
 
 void MapView::keyPressEvent(QKeyEvent *event)
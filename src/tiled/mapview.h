@@ -108,6 +108,7 @@ signals:
 private:
     void adjustScale(qreal scale);
     void setUseOpenGL(bool useOpenGL);
+    void updateViewRect();
     void updateSceneRect(const QRectF &sceneRect);
     void updateSceneRect(const QRectF &sceneRect, const QTransform &transform);
     void focusMapObject(MapObject *mapObject);
@@ -124,7 +124,7 @@ void ObjectsTreeView::setSelectedObject(int id)
         return;
     }
 
-    if (auto object = mMapDocument->map()->findObjectById(id))
+    if (auto object = mMapDocument->objectReferences().findObjectById(id))
         setSelectedObject(object);
     else
         ERROR(QLatin1String("No object found with id ") + QString::number(id));
@@ -0,0 +1,149 @@
+/*
+ * objectreferencegraph.cpp
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "objectreferencegraph.h"
+
+#include "grouplayer.h"
+#include "map.h"
+#include "mapobject.h"
+#include "objectgroup.h"
+#include "properties.h"
+
+namespace Tiled {
+
+/**
+ * Rebuilds the graph from scratch, based on all objects in the given \a map.
+ */
+void ObjectReferenceGraph::reset(const Map *map)
+{
+    mObjectsById.clear();
+    mReferencesBySource.clear();
+    mSourcesByTargetId.clear();
+
+    if (!map)
+        return;
+
+    for (Layer *layer : map->objectGroups())
+        for (MapObject *mapObject : static_cast<ObjectGroup*>(layer)->objects())
+            addObject(mapObject);
+}
+
+void ObjectReferenceGraph::addObjects(const QList<MapObject *> &objects)
+{
+    for (MapObject *object : objects)
+        addObject(object);
+}
+
+void ObjectReferenceGraph::removeObjects(const QList<MapObject *> &objects)
+{
+    for (MapObject *object : objects)
+        removeObject(object);
+}
+
+/**
+ * Adds the objects of the given \a layer, which may be an object layer or a
+ * group layer.
+ */
+void ObjectReferenceGraph::addLayer(Layer *layer)
+{
+    if (ObjectGroup *objectGroup = layer->asObjectGroup()) {
+        addObjects(objectGroup->objects());
+    } else if (GroupLayer *groupLayer = layer->asGroupLayer()) {
+        for (Layer *childLayer : *groupLayer)
+            addLayer(childLayer);
+    }
+}
+
+/**
+ * Removes the objects of the given \a layer, which may be an object layer or
+ * a group layer.
+ */
+void ObjectReferenceGraph::removeLayer(Layer *layer)
+{
+    if (ObjectGroup *objectGroup = layer->asObjectGroup()) {
+        removeObjects(objectGroup->objects());
+    } else if (GroupLayer *groupLayer = layer->asGroupLayer()) {
+        for (Layer *childLayer : *groupLayer)
+            removeLayer(childLayer);
+    }
+}
+
+/**
+ * Updates the references stored for the given \a object, based on its
+ * current properties. Should be called whenever its properties change.
+ */
+void ObjectReferenceGraph::updateReferences(MapObject *object)
+{
+    removeReferences(object);
+
+    QVector<Reference> references;
+
+    const auto &props = object->properties();
+    for (auto it = props.cbegin(), it_end = props.cend(); it != it_end; ++it) {
+        if (it->userType() != objectRefTypeId())
+            continue;
+
+        const int targetId = it->value<ObjectRef>().id;
+        if (targetId <= 0)
+            continue;
+
+        references.append(Reference { it.key(), targetId });
+        mSourcesByTargetId[targetId].append(object);
+    }
+
+    if (!references.isEmpty())
+        mReferencesBySource.insert(object, references);
+}
+
+void ObjectReferenceGraph::addObject(MapObject *object)
+{
+    mObjectsById[object->id()].append(object);
+
+    updateReferences(object);
+}
+
+void ObjectReferenceGraph::removeObject(MapObject *object)
+{
+    auto it = mObjectsById.find(object->id());
+    if (it != mObjectsById.end()) {
+        it->removeOne(object);
+        if (it->isEmpty())
+            mObjectsById.erase(it);
+    }
+
+    removeReferences(object);
+}
+
+void ObjectReferenceGraph::removeReferences(MapObject *object)
+{
+    const QVector<Reference> references = mReferencesBySource.take(object);
+
+    for (const Reference &reference : references) {
+        auto it = mSourcesByTargetId.find(reference.targetId);
+        if (it == mSourcesByTargetId.end())
+            continue;
+
+        it->removeOne(object);
+        if (it->isEmpty())
+            mSourcesByTargetId.erase(it);
+    }
+}
+
+} // namespace Tiled
@@ -0,0 +1,119 @@
+/*
+ * objectreferencegraph.h
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+namespace Tiled {
+
+class Layer;
+class Map;
+class MapObject;
+
+/**
+ * Keeps track of the object references between the objects of a map.
+ *
+ * For each object, the references stored in its properties are indexed by
+ * source object as well as by target object ID. The objects themselves are
+ * indexed by ID, so that resolving a reference doesn't require a search
+ * through all object layers. All objects sharing an ID are kept, so that
+ * removing one of them leaves the others findable.
+ *
+ * The graph is maintained by the MapDocument, based on its change events.
+ */
+class ObjectReferenceGraph
+{
+public:
+    struct Reference
+    {
+        QString property;
+        int targetId;
+    };
+
+    void reset(const Map *map);
+
+    void addObjects(const QList<MapObject*> &objects);
+    void removeObjects(const QList<MapObject*> &objects);
+    void addLayer(Layer *layer);
+    void removeLayer(Layer *layer);
+
+    void updateReferences(MapObject *object);
+
+    MapObject *findObjectById(int id) const;
+
+    const QHash<MapObject*, QVector<Reference>> &references() const;
+    QVector<Reference> referencesFrom(MapObject *object) const;
+    QVector<MapObject*> referencesTo(int targetId) const;
+
+private:
+    void addObject(MapObject *object);
+    void removeObject(MapObject *object);
+    void removeReferences(MapObject *object);
+
+    QHash<int, QVector<MapObject*>> mObjectsById;
+    QHash<MapObject*, QVector<Reference>> mReferencesBySource;
+    QHash<int, QVector<MapObject*>> mSourcesByTargetId;
+};
+
+
+/**
+ * Returns the object with the given \a id, or nullptr if no such object
+ * exists in the map.
+ *
+ * In case of duplicate IDs the object added first is returned, like
+ * Map::findObjectById returns the first one.
+ */
+inline MapObject *ObjectReferenceGraph::findObjectById(int id) const
+{
+    auto it = mObjectsById.find(id);
+    return it != mObjectsById.end() ? it->first() : nullptr;
+}
+
+/**
+ * Returns all references, indexed by source object.
+ */
+inline const QHash<MapObject*, QVector<ObjectReferenceGraph::Reference>> &ObjectReferenceGraph::references() const
+{
+    return mReferencesBySource;
+}
+
+/**
+ * Returns the references stored in the properties of the given \a object.
+ */
+inline QVector<ObjectReferenceGraph::Reference> ObjectReferenceGraph::referencesFrom(MapObject *object) const
+{
+    return mReferencesBySource.value(object);
+}
+
+/**
+ * Returns the objects referring to the object with the given \a targetId.
+ * An object is listed once for each of its properties referring to the
+ * target.
+ */
+inline QVector<MapObject*> ObjectReferenceGraph::referencesTo(int targetId) const
+{
+    return mSourcesByTargetId.value(targetId);
+}
+
+} // namespace Tiled
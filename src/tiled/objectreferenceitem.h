@@ -58,12 +58,12 @@ public:
                const QStyleOptionGraphicsItem *,
                QWidget *) override;
 
-private:
-    void updateArrowRotation();
-
     static QPointF objectCenter(MapObject *object,
                                 const MapRenderer &renderer);
 
+private:
+    void updateArrowRotation();
+
     QPointF mSourcePos;
     QPointF mTargetPos;
     MapObject *mSourceObject;
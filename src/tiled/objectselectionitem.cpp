@@ -35,6 +35,7 @@
 #include "variantpropertymanager.h"
 
 #include <QGuiApplication>
+#include <QSet>
 #include <QTimerEvent>
 #include <QVector2D>
 
@@ -300,8 +301,7 @@ ObjectSelectionItem::ObjectSelectionItem(MapDocument *mapDocument,
     if (objectLabelVisibility() == Preferences::AllObjectLabels)
         addRemoveObjectLabels();
 
-    if (Preferences::instance()->showObjectReferences())
-        addRemoveObjectReferences();
+    // Object references are added once the view rect is set
 }
 
 ObjectSelectionItem::~ObjectSelectionItem()
@@ -313,15 +313,53 @@ const MapRenderer &ObjectSelectionItem::mapRenderer() const
     return *mMapDocument->renderer();
 }
 
+/**
+ * Sets the area visible in the view, in scene coordinates. Reference items
+ * are only created for references that pass near this area, since maps may
+ * contain huge amounts of references.
+ *
+ * A null \a viewRect means the visible area is unknown, in which case items
+ * are created for all references.
+ */
+void ObjectSelectionItem::setViewRect(const QRectF &viewRect)
+{
+    mViewRect = viewRect;
+
+    if (!Preferences::instance()->showObjectReferences())
+        return;
+
+    // No need to update the references while the view stays within the area
+    // for which reference items have been created
+    if (!mReferencesRect.isNull() && !viewRect.isNull() &&
+            mReferencesRect.contains(mapRectFromScene(viewRect)))
+        return;
+
+    addRemoveObjectReferences();
+}
+
 void ObjectSelectionItem::changeEvent(const ChangeEvent &event)
 {
     switch (event.type) {
     case ChangeEvent::LayerChanged:
         layerChanged(static_cast<const LayerChangeEvent&>(event).layer);
         break;
-    case ChangeEvent::MapObjectsChanged:
-        syncOverlayItems(static_cast<const MapObjectsChangeEvent&>(event).mapObjects);
+    case ChangeEvent::MapObjectsChanged: {
+        const auto &objectsChange = static_cast<const MapObjectsChangeEvent&>(event);
+        syncOverlayItems(objectsChange.mapObjects);
+
+        // Update the reference items when references may have changed, or
+        // when objects may have moved into or out of view
+        const MapObject::ChangedProperties referenceProperties =
+                MapObject::CustomProperties | MapObject::TemplateProperty |
+                MapObject::PositionProperty | MapObject::SizeProperty |
+                MapObject::ShapeProperty;
+
+        if (objectsChange.properties == MapObject::AllProperties ||
+                objectsChange.properties & referenceProperties) {
+            addRemoveObjectReferences(objectsChange.mapObjects);
+        }
         break;
+    }
     case ChangeEvent::MapObjectsAdded:
         objectsAdded(static_cast<const MapObjectsEvent&>(event).mapObjects);
         break;
@@ -473,8 +511,7 @@ void ObjectSelectionItem::layerAdded(Layer *layer)
         }
     }
 
-    if (Preferences::instance()->showObjectReferences())
-        addRemoveObjectReferences();
+    addRemoveObjectReferences(newObjects);
 }
 
 void ObjectSelectionItem::layerAboutToBeRemoved(GroupLayer *parentLayer, int index)
@@ -561,12 +598,9 @@ void ObjectSelectionItem::objectsAdded(const QList<MapObject *> &objects)
         }
     }
 
-    // This could be a tad slow if there are many objects, but currently it is
-    // necessary because the list of added objects could include target
-    // objects. To optimize this, we could instantiate reference items also if
-    // the target was not found and only try to repair those here.
-    if (Preferences::instance()->showObjectReferences())
-        addRemoveObjectReferences();
+    // The list of added objects could include target objects, so this also
+    // updates the references of any objects referring to them.
+    addRemoveObjectReferences(objects);
 }
 
 void ObjectSelectionItem::objectsAboutToBeRemoved(const QList<MapObject *> &objects)
@@ -589,6 +623,20 @@ void ObjectSelectionItem::objectsAboutToBeRemoved(const QList<MapObject *> &obje
             }
             mReferencesBySourceObject.erase(it);
         }
+
+        // Also remove any references to this object, since they can no
+        // longer be resolved. They are restored when the object is re-added.
+        const auto targetItems = mReferencesByTargetObject.take(object);
+        for (auto item : targetItems) {
+            auto sourceIt = mReferencesBySourceObject.find(item->sourceObject());
+            if (sourceIt != mReferencesBySourceObject.end()) {
+                sourceIt->removeOne(item);
+                if (sourceIt->isEmpty())
+                    mReferencesBySourceObject.erase(sourceIt);
+            }
+
+            delete item;
+        }
     }
 }
 
@@ -723,12 +771,16 @@ void ObjectSelectionItem::addRemoveObjectReferences()
     QHash<MapObject*, QList<ObjectReferenceItem*>> referencesBySourceObject;
     QHash<MapObject*, QList<ObjectReferenceItem*>> referencesByTargetObject;
     const MapRenderer &renderer = *mMapDocument->renderer();
+    const ObjectReferenceGraph &graph = mMapDocument->objectReferences();
+
+    updateReferencesRect();
 
-    auto ensureReferenceItem = [&] (MapObject *sourceObject, const QString &property, ObjectRef ref) {
-        MapObject *targetObject = DisplayObjectRef(ref, mMapDocument).object();
-        if (!targetObject)
+    auto ensureReferenceItem = [&] (MapObject *sourceObject, const ObjectReferenceGraph::Reference &reference) {
+        MapObject *targetObject = graph.findObjectById(reference.targetId);
+        if (!targetObject || !isReferenceInView(sourceObject, targetObject))
             return;
 
+        const QString &property = reference.property;
         QList<ObjectReferenceItem*> &items = referencesBySourceObject[sourceObject];
 
         if (mReferencesBySourceObject.contains(sourceObject)) {
@@ -757,20 +809,14 @@ void ObjectSelectionItem::addRemoveObjectReferences()
     };
 
     if (Preferences::instance()->showObjectReferences()) {
-        LayerIterator iterator(mMapDocument->map());
-        while (Layer *layer = iterator.next()) {
-            if (layer->isHidden())
+        const auto &references = graph.references();
+        for (auto it = references.cbegin(), it_end = references.cend(); it != it_end; ++it) {
+            MapObject *sourceObject = it.key();
+            if (sourceObject->objectGroup()->isHidden())
                 continue;
 
-            if (ObjectGroup *objectGroup = layer->asObjectGroup()) {
-                for (MapObject *object : objectGroup->objects()) {
-                    const auto &props = object->properties();
-                    for (auto it = props.cbegin(), it_end = props.cend(); it != it_end; ++it) {
-                        if (it->userType() == objectRefTypeId())
-                            ensureReferenceItem(object, it.key(), it->value<ObjectRef>());
-                    }
-                }
-            }
+            for (const auto &reference : it.value())
+                ensureReferenceItem(sourceObject, reference);
         }
     }
 
@@ -789,12 +835,14 @@ void ObjectSelectionItem::addRemoveObjectReferences(MapObject *object)
     items.swap(existingItems);
 
     const MapRenderer &renderer = *mMapDocument->renderer();
+    const ObjectReferenceGraph &graph = mMapDocument->objectReferences();
 
-    auto ensureReferenceItem = [&] (MapObject *sourceObject, const QString &property, ObjectRef ref) {
-        MapObject *targetObject = DisplayObjectRef(ref, mMapDocument).object();
-        if (!targetObject)
+    auto ensureReferenceItem = [&] (MapObject *sourceObject, const ObjectReferenceGraph::Reference &reference) {
+        MapObject *targetObject = graph.findObjectById(reference.targetId);
+        if (!targetObject || !isReferenceInView(sourceObject, targetObject))
             return;
 
+        const QString &property = reference.property;
         auto it = std::find_if(existingItems.begin(),
                                existingItems.end(),
                                [=] (ObjectReferenceItem *item) {
@@ -815,14 +863,14 @@ void ObjectSelectionItem::addRemoveObjectReferences(MapObject *object)
         mReferencesByTargetObject[targetObject].append(item);
     };
 
-    if (Preferences::instance()->showObjectReferences()) {
-        const auto &props = object->properties();
-        for (auto it = props.cbegin(), it_end = props.cend(); it != it_end; ++it) {
-            if (it->userType() == objectRefTypeId())
-                ensureReferenceItem(object, it.key(), it->value<ObjectRef>());
-        }
+    if (Preferences::instance()->showObjectReferences() && !object->objectGroup()->isHidden()) {
+        const auto references = graph.referencesFrom(object);
+        for (const auto &reference : references)
+            ensureReferenceItem(object, reference);
     }
 
+    const bool hasReferences = !items.isEmpty();
+
     // Delete remaining existing items, also removing them from mReferencesByTargetObject
     for (ObjectReferenceItem *item : existingItems) {
         auto &itemsByTarget = mReferencesByTargetObject[item->targetObject()];
@@ -832,6 +880,63 @@ void ObjectSelectionItem::addRemoveObjectReferences(MapObject *object)
 
         delete item;
     }
+
+    if (!hasReferences)
+        mReferencesBySourceObject.remove(object);
+}
+
+/**
+ * Updates the reference items for the given \a objects, as well as for the
+ * objects referring to any of them.
+ */
+void ObjectSelectionItem::addRemoveObjectReferences(const QList<MapObject *> &objects)
+{
+    if (!Preferences::instance()->showObjectReferences())
+        return;
+
+    const ObjectReferenceGraph &graph = mMapDocument->objectReferences();
+    QSet<MapObject*> affectedObjects;
+
+    for (MapObject *object : objects) {
+        affectedObjects.insert(object);
+
+        const auto sourceObjects = graph.referencesTo(object->id());
+        for (MapObject *sourceObject : sourceObjects)
+            affectedObjects.insert(sourceObject);
+    }
+
+    for (MapObject *object : qAsConst(affectedObjects))
+        addRemoveObjectReferences(object);
+}
+
+void ObjectSelectionItem::updateReferencesRect()
+{
+    if (mViewRect.isNull()) {
+        mReferencesRect = QRectF();
+        return;
+    }
+
+    // Include a margin around the view, to avoid having to update the
+    // reference items each time the view is scrolled a little
+    const QRectF viewRect = mapRectFromScene(mViewRect);
+    const qreal marginX = viewRect.width() / 2;
+    const qreal marginY = viewRect.height() / 2;
+
+    mReferencesRect = viewRect.adjusted(-marginX, -marginY, marginX, marginY);
+}
+
+bool ObjectSelectionItem::isReferenceInView(MapObject *sourceObject,
+                                            MapObject *targetObject) const
+{
+    if (mReferencesRect.isNull())
+        return true;
+
+    const MapRenderer &renderer = mapRenderer();
+    const QPointF sourcePos = ObjectReferenceItem::objectCenter(sourceObject, renderer);
+    const QPointF targetPos = ObjectReferenceItem::objectCenter(targetObject, renderer);
+    const QRectF bounds = QRectF(sourcePos, targetPos).normalized().adjusted(-1, -1, 1, 1);
+
+    return bounds.intersects(mReferencesRect);
 }
 
 } // namespace Tiled
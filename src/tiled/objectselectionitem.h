@@ -58,6 +58,8 @@ public:
 
     const MapRenderer &mapRenderer() const;
 
+    void setViewRect(const QRectF &viewRect);
+
     // QGraphicsItem interface
     QRectF boundingRect() const override { return QRectF(); }
     void paint(QPainter *, const QStyleOptionGraphicsItem *, QWidget *) override {}
@@ -89,6 +91,9 @@ private:
     void addRemoveObjectOutlines();
     void addRemoveObjectReferences();
     void addRemoveObjectReferences(MapObject *object);
+    void addRemoveObjectReferences(const QList<MapObject*> &objects);
+    void updateReferencesRect();
+    bool isReferenceInView(MapObject *sourceObject, MapObject *targetObject) const;
 
     MapDocument *mMapDocument;
     QHash<MapObject*, MapObjectLabel*> mObjectLabels;
@@ -96,6 +101,8 @@ private:
     QHash<MapObject*, QList<ObjectReferenceItem*>> mReferencesBySourceObject;
     QHash<MapObject*, QList<ObjectReferenceItem*>> mReferencesByTargetObject;
     std::unique_ptr<MapObjectItem> mHoveredMapObjectItem;
+    QRectF mViewRect;
+    QRectF mReferencesRect;
 };
 
 } // namespace Tiled
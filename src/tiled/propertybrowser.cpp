@@ -388,13 +388,7 @@ static QVariant predefinedPropertyValue(Object *object, const QString &name)
     if (objectType.isEmpty())
         return QVariant();
 
-    for (const ObjectType &type : Object::objectTypes()) {
-        if (type.name == objectType)
-            if (type.defaultProperties.contains(name))
-                return type.defaultProperties.value(name);
-    }
-
-    return QVariant();
+    return Object::objectTypeProperties(objectType).value(name);
 }
 
 static bool anyObjectHasProperty(const QList<Object*> &objects, const QString &name)
@@ -1885,15 +1879,11 @@ void PropertyBrowser::updateCustomProperties()
 
     if (!objectType.isEmpty()) {
         // Inherit properties from the object type
-        for (const ObjectType &type : Object::objectTypes()) {
-            if (type.name == objectType) {
-                QMapIterator<QString,QVariant> it(type.defaultProperties);
-                while (it.hasNext()) {
-                    it.next();
-                    if (!mCombinedProperties.contains(it.key()))
-                        mCombinedProperties.insert(it.key(), it.value());
-                }
-            }
+        QMapIterator<QString,QVariant> it(Object::objectTypeProperties(objectType));
+        while (it.hasNext()) {
+            it.next();
+            if (!mCombinedProperties.contains(it.key()))
+                mCombinedProperties.insert(it.key(), it.value());
         }
     }
 
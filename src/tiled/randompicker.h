@@ -20,7 +20,7 @@
 
 #pragma once
 
-#include <QMap>
+#include <QVector>
 
 #include <random>
 
@@ -35,6 +35,9 @@ inline std::default_random_engine &globalRandomEngine()
 /**
  * A class that helps pick random things that each have a probability
  * assigned.
+ *
+ * Picking is done in constant time using Vose's alias method. The alias
+ * table is built on the first pick after the set of values has changed.
  */
 template<typename T, typename Real = qreal>
 class RandomPicker
@@ -42,32 +45,47 @@ class RandomPicker
 public:
     RandomPicker()
         : mSum(0.0)
+        , mAliasTableValid(false)
     {}
 
     void add(const T &value, Real probability = 1.0)
     {
         if (probability > 0) {
             mSum += probability;
-            mThresholds.insert(mSum, value);
+            mValues.append(value);
+            mProbabilities.append(probability);
+            mAliasTableValid = false;
         }
     }
 
     bool isEmpty() const
     {
-        return mThresholds.isEmpty();
+        return mValues.isEmpty();
+    }
+
+    int size() const
+    {
+        return mValues.size();
     }
 
     const T &pick() const
     {
         Q_ASSERT(!isEmpty());
 
-        std::uniform_real_distribution<Real> dis(0, mSum);
-        const Real random = dis(globalRandomEngine());
-        const auto it = mThresholds.lowerBound(random);
-        if (it != mThresholds.end())
-            return it.value();
+        if (!mAliasTableValid)
+            buildAliasTable();
+
+        auto &engine = globalRandomEngine();
+        std::uniform_int_distribution<int> indexDis(0, mValues.size() - 1);
+        std::uniform_real_distribution<Real> dis(0, 1);
+
+        const int index = indexDis(engine);
+        const AliasEntry &entry = mAliasTable.at(index);
+
+        if (dis(engine) < entry.probability)
+            return mValues.at(index);
         else
-            return (mThresholds.end() - 1).value();
+            return mValues.at(entry.alias);
     }
 
     //same as pick, but removes the selected element.
@@ -76,24 +94,92 @@ public:
         Q_ASSERT(!isEmpty());
 
         std::uniform_real_distribution<Real> dis(0, mSum);
-        const Real random = dis(globalRandomEngine());
-        const auto it = mThresholds.lowerBound(random);
+        Real random = dis(globalRandomEngine());
+
+        // Since removing a value invalidates the alias table, a linear search
+        // is cheaper here.
+        const int last = mValues.size() - 1;
+        int index = 0;
+        while (index < last && random >= mProbabilities.at(index)) {
+            random -= mProbabilities.at(index);
+            ++index;
+        }
 
-        if (it != mThresholds.end())
-            return mThresholds.take(it.key());
-        else
-            return mThresholds.take((it - 1).key());
+        mSum -= mProbabilities.at(index);
+        mProbabilities.remove(index);
+        mAliasTableValid = false;
+
+        if (mProbabilities.isEmpty())
+            mSum = 0.0;
+
+        return mValues.takeAt(index);
     }
 
     void clear()
     {
         mSum = 0.0;
-        mThresholds.clear();
+        mValues.clear();
+        mProbabilities.clear();
+        mAliasTable.clear();
+        mAliasTableValid = false;
     }
 
 private:
+    struct AliasEntry
+    {
+        Real probability;
+        int alias;
+    };
+
+    void buildAliasTable() const
+    {
+        const int count = mValues.size();
+
+        // Probabilities scaled such that their average is 1
+        QVector<Real> scaled(count);
+        QVector<int> small;
+        QVector<int> large;
+        small.reserve(count);
+        large.reserve(count);
+
+        for (int i = 0; i < count; ++i) {
+            scaled[i] = mProbabilities.at(i) * count / mSum;
+            if (scaled[i] < 1)
+                small.append(i);
+            else
+                large.append(i);
+        }
+
+        mAliasTable.resize(count);
+
+        while (!small.isEmpty() && !large.isEmpty()) {
+            const int less = small.takeLast();
+            const int more = large.takeLast();
+
+            mAliasTable[less] = AliasEntry { scaled[less], more };
+
+            scaled[more] = (scaled[more] + scaled[less]) - 1;
+            if (scaled[more] < 1)
+                small.append(more);
+            else
+                large.append(more);
+        }
+
+        // Any remaining entries have a probability of 1, give or take some
+        // rounding errors
+        for (int i = 0; i < large.size(); ++i)
+            mAliasTable[large.at(i)] = AliasEntry { 1, large.at(i) };
+        for (int i = 0; i < small.size(); ++i)
+            mAliasTable[small.at(i)] = AliasEntry { 1, small.at(i) };
+
+        mAliasTableValid = true;
+    }
+
     Real mSum;
-    QMap<Real, T> mThresholds;
+    QVector<T> mValues;
+    QVector<Real> mProbabilities;
+    mutable QVector<AliasEntry> mAliasTable;
+    mutable bool mAliasTableValid;
 };
 
 } // namespace Tiled
@@ -0,0 +1,90 @@
+/*
+ * remaptiles.cpp
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "remaptiles.h"
+
+#include "changemapobject.h"
+#include "map.h"
+#include "mapdocument.h"
+#include "mapobject.h"
+#include "objectgroup.h"
+#include "painttilelayer.h"
+#include "tilelayer.h"
+#include "tileremapping.h"
+
+#include <QCoreApplication>
+
+namespace Tiled {
+
+RemapTiles::RemapTiles(MapDocument *mapDocument,
+                       const TileRemapping &remapping,
+                       QUndoCommand *parent)
+    : QUndoCommand(QCoreApplication::translate("Undo Commands",
+                                               "Replace Tiles"),
+                   parent)
+{
+    QVector<MapObjectCell> objectChanges;
+
+    LayerIterator iterator(mapDocument->map());
+    while (Layer *layer = iterator.next()) {
+        switch (layer->layerType()) {
+        case Layer::TileLayerType: {
+            TileLayer *tileLayer = static_cast<TileLayer*>(layer);
+
+            QRegion changedRegion;
+            const auto changedLayer = remapping.remapped(*tileLayer, changedRegion);
+
+            if (!changedRegion.isEmpty()) {
+                new PaintTileLayer(mapDocument, tileLayer,
+                                   tileLayer->x(), tileLayer->y(),
+                                   changedLayer.get(),
+                                   changedRegion.translated(tileLayer->position()),
+                                   this);
+            }
+
+            break;
+        }
+
+        case Layer::ObjectGroupType:
+            for (MapObject *mapObject : *static_cast<ObjectGroup*>(layer)) {
+                if (mapObject->isTemplateInstance() && !mapObject->propertyChanged(MapObject::CellProperty))
+                    continue;
+
+                const Cell mappedCell = remapping.map(mapObject->cell());
+                if (mappedCell != mapObject->cell()) {
+                    MapObjectCell change;
+                    change.object = mapObject;
+                    change.cell = mappedCell;
+                    objectChanges.append(change);
+                }
+            }
+            break;
+
+        case Layer::ImageLayerType:
+        case Layer::GroupLayerType:
+            break;
+        }
+    }
+
+    if (!objectChanges.isEmpty())
+        new ChangeMapObjectCells(mapDocument, objectChanges, this);
+}
+
+} // namespace Tiled
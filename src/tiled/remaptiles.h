@@ -0,0 +1,46 @@
+/*
+ * remaptiles.h
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QUndoCommand>
+
+namespace Tiled {
+
+class TileRemapping;
+
+class MapDocument;
+
+/**
+ * Replaces tiles on all layers of a map, based on a TileRemapping.
+ *
+ * Only the changed cells are recorded, using a PaintTileLayer command per
+ * affected tile layer and a single ChangeMapObjectCells command for the
+ * affected tile objects.
+ */
+class RemapTiles : public QUndoCommand
+{
+public:
+    RemapTiles(MapDocument *mapDocument,
+               const TileRemapping &remapping,
+               QUndoCommand *parent = nullptr);
+};
+
+} // namespace Tiled
@@ -28,6 +28,7 @@
 #include "logginginterface.h"
 #include "mainwindow.h"
 #include "mapeditor.h"
+#include "mapformat.h"
 #include "scriptedaction.h"
 #include "scriptedfileformat.h"
 #include "scriptedtool.h"
@@ -35,6 +36,7 @@
 #include "scriptmanager.h"
 #include "tilesetdocument.h"
 #include "tileseteditor.h"
+#include "tilesetformat.h"
 
 #include <QAction>
 #include <QCoreApplication>
@@ -341,11 +343,8 @@ ScriptMapFormatWrapper *ScriptModule::mapFormat(const QString &shortName) const
 
 ScriptMapFormatWrapper *ScriptModule::mapFormatForFile(const QString &fileName) const
 {
-    const auto formats = PluginManager::objects<MapFormat>();
-    for (auto format : formats) {
-        if (format->supportsFile(fileName))
-            return new ScriptMapFormatWrapper(format);
-    }
+    if (auto format = findSupportingMapFormat(fileName))
+        return new ScriptMapFormatWrapper(format);
 
     return nullptr;
 }
@@ -363,11 +362,8 @@ ScriptTilesetFormatWrapper *ScriptModule::tilesetFormat(const QString &shortName
 
 ScriptTilesetFormatWrapper *ScriptModule::tilesetFormatForFile(const QString &fileName) const
 {
-    const auto formats = PluginManager::objects<TilesetFormat>();
-    for (auto format : formats) {
-        if (format->supportsFile(fileName))
-            return new ScriptTilesetFormatWrapper(format);
-    }
+    if (auto format = findSupportingTilesetFormat(fileName))
+        return new ScriptTilesetFormatWrapper(format);
 
     return nullptr;
 }
@@ -46,7 +46,7 @@ void SelectSameTileTool::tilePositionChanged(QPoint tilePos)
     QRegion resultRegion;
     if (mapDocument()->map()->infinite() || tileLayer->contains(tilePos)) {
         const Cell &matchCell = tileLayer->cellAt(tilePos);
-        resultRegion = tileLayer->region([&] (const Cell &cell) { return cell == matchCell; });
+        resultRegion = tileLayer->cellRegion(matchCell);
     }
     setSelectedRegion(resultRegion);
     brushItem()->setTileRegion(selectedRegion());
@@ -25,6 +25,7 @@
 #include "mapobject.h"
 #include "objectgroup.h"
 #include "tilelayer.h"
+#include "tileremapping.h"
 
 #include <QCoreApplication>
 
@@ -49,8 +50,9 @@ void SwapTiles::swap()
 
     QList<MapObject*> changedObjects;
 
-    auto isTile1 = [=](const Cell &cell) { return cell.refersTile(tile1); };
-    auto isTile2 = [=](const Cell &cell) { return cell.refersTile(tile2); };
+    TileRemapping remapping;
+    remapping.insert(tile1, tile2);
+    remapping.insert(tile2, tile1);
 
     auto swapObjectTile = [=,&changedObjects](MapObject *object, Tile *fromTile, Tile *toTile) {
         Cell cell = object->cell();
@@ -66,13 +68,10 @@ void SwapTiles::swap()
         switch (layer->layerType()) {
         case Layer::TileLayerType: {
             auto tileLayer = static_cast<TileLayer*>(layer);
-            auto region1 = tileLayer->region(isTile1);
-            auto region2 = tileLayer->region(isTile2);
+            const QRegion changedRegion = remapping.apply(*tileLayer);
 
-            tileLayer->setTiles(region1, tile2);
-            tileLayer->setTiles(region2, tile1);
-
-            emit mMapDocument->regionChanged(region1 | region2, tileLayer);
+            if (!changedRegion.isEmpty())
+                emit mMapDocument->regionChanged(changedRegion.translated(tileLayer->position()), tileLayer);
 
             break;
         }
@@ -128,6 +128,7 @@ SOURCES += aboutdialog.cpp \
     erasetiles.cpp \
     exportasimagedialog.cpp \
     exporthelper.cpp \
+    exportwatcher.cpp \
     filechangedwarning.cpp \
     fileedit.cpp \
     filteredit.cpp \
@@ -173,6 +174,7 @@ SOURCES += aboutdialog.cpp \
     objectgroupitem.cpp \
     objectrefdialog.cpp \
     objectrefedit.cpp \
+    objectreferencegraph.cpp \
     objectreferenceitem.cpp \
     objectreferencetool.cpp \
     objectsdock.cpp \
@@ -195,6 +197,7 @@ SOURCES += aboutdialog.cpp \
     propertybrowser.cpp \
     raiselowerhelper.cpp \
     regionvaluetype.cpp \
+    remaptiles.cpp \
     renamewangset.cpp \
     reparentlayers.cpp \
     replacetemplate.cpp \
@@ -364,6 +367,7 @@ HEADERS += aboutdialog.h \
     erasetiles.h \
     exportasimagedialog.h \
     exporthelper.h \
+    exportwatcher.h \
     filechangedwarning.h \
     fileedit.h \
     filteredit.h \
@@ -409,6 +413,7 @@ HEADERS += aboutdialog.h \
     objectgroupitem.h \
     objectrefdialog.h \
     objectrefedit.h \
+    objectreferencegraph.h \
     objectreferenceitem.h \
     objectreferencetool.h \
     objectsdock.h \
@@ -433,6 +438,7 @@ HEADERS += aboutdialog.h \
     randompicker.h \
     rangeset.h \
     regionvaluetype.h \
+    remaptiles.h \
     renamewangset.h \
     reparentlayers.h \
     replacetemplate.h \
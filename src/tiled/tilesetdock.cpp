@@ -65,16 +65,25 @@
 #include <QStackedWidget>
 #include <QStylePainter>
 #include <QToolBar>
+#include <QTimer>
 #include <QToolButton>
 #include <QUrl>
 #include <QVBoxLayout>
 
+#include "qtcompat_p.h"
+
 #include <functional>
 
 using namespace Tiled;
 
 namespace {
 
+/**
+ * The maximum number of tileset views kept around, including the ones whose
+ * tab is currently not shown.
+ */
+static const int MaxTilesetViews = 16;
+
 class NoTilesetWidget : public QWidget
 {
     Q_OBJECT
@@ -160,6 +169,21 @@ static void removeTileReferences(MapDocument *mapDocument,
         undoStack->push(new RemoveMapObjects(mapDocument, objectsToRemove));
 }
 
+static QString tilesetScalePath(const Tileset &tileset)
+{
+    return QLatin1String("TilesetDock/TilesetScale/") + tileset.name();
+}
+
+static void saveTilesetScale(const Tileset &tileset, const TilesetView *view)
+{
+    const QString path = tilesetScalePath(tileset);
+    auto preferences = Preferences::instance();
+    if (view->scale() != 1.0)
+        preferences->setValue(path, view->scale());
+    else
+        preferences->remove(path);
+}
+
 } // anonymous namespace
 
 TilesetDock::TilesetDock(QWidget *parent)
@@ -266,9 +290,10 @@ TilesetDock::TilesetDock(QWidget *parent)
     mZoomComboBox = new QComboBox;
     horizontal->addWidget(mZoomComboBox);
 
-    connect(mViewStack, &QStackedWidget::currentChanged,
+    // Connected after updateActions, which makes sure the view exists
+    connect(mTabBar, &QTabBar::currentChanged,
             this, &TilesetDock::updateCurrentTiles);
-    connect(mViewStack, &QStackedWidget::currentChanged,
+    connect(mTabBar, &QTabBar::currentChanged,
             this, &TilesetDock::currentTilesetChanged);
 
     connect(TilesetManager::instance(), &TilesetManager::tilesetImagesChanged,
@@ -333,9 +358,19 @@ void TilesetDock::setMapDocument(MapDocument *mapDocument)
                 this, &TilesetDock::updateActions);
         connect(mMapDocument, &MapDocument::tilesetReplaced,
                 this, &TilesetDock::updateActions);
+
+        connect(mMapDocument, &MapDocument::regionChanged,
+                this, &TilesetDock::scheduleTileUsageUpdate);
+        connect(mMapDocument, &MapDocument::changed,
+                this, &TilesetDock::scheduleTileUsageUpdate);
+        connect(mMapDocument, &MapDocument::layerAdded,
+                this, &TilesetDock::scheduleTileUsageUpdate);
+        connect(mMapDocument, &MapDocument::layerRemoved,
+                this, &TilesetDock::scheduleTileUsageUpdate);
     }
 
     updateActions();
+    scheduleTileUsageUpdate();
 
 #ifndef Q_OS_OSX
     widget()->show();
@@ -370,10 +405,7 @@ void TilesetDock::selectTiles(const QList<Tile *> &tiles)
         Tileset *tileset = tile->tileset();
         int tilesetIndex = mTilesets.indexOf(tileset->sharedPointer());
         if (tilesetIndex != -1) {
-            TilesetView *view = tilesetViewAt(tilesetIndex);
-            if (!view->model()) // Lazily set up the model
-                setupTilesetModel(view, tileset);
-
+            TilesetView *view = activateTilesetView(tilesetIndex);
             const TilesetModel *model = view->tilesetModel();
             const QModelIndex modelIndex = model->tileIndex(tile);
             QItemSelectionModel *selectionModel = view->selectionModel();
@@ -476,16 +508,11 @@ void TilesetDock::updateActions()
     const int index = mTabBar->currentIndex();
 
     if (index > -1) {
-        view = tilesetViewAt(index);
+        view = activateTilesetView(index);
         tileset = mTilesets.at(index).data();
 
-        if (view) {
-            if (!view->model()) // Lazily set up the model
-                setupTilesetModel(view, tileset);
-
-            mViewStack->setCurrentIndex(index);
-            external = tileset->isExternal();
-        }
+        mViewStack->setCurrentWidget(view);
+        external = tileset->isExternal();
     }
 
     const bool tilesetIsDisplayed = view != nullptr;
@@ -552,57 +579,37 @@ void TilesetDock::createTilesetView(int index, TilesetDocument *tilesetDocument)
 {
     auto tileset = tilesetDocument->tileset();
 
+    // The tileset view is only created once the tab is activated. Insert
+    // the tileset before the tab to make sure it is there when the tab index
+    // changes (happens when first tab is inserted).
     mTilesets.insert(index, tileset);
     mTilesetDocuments.insert(index, tilesetDocument);
 
-    TilesetView *view = new TilesetView;
-
     // Hides the "New Tileset..." special view if it is shown.
     mSuperViewStack->setCurrentIndex(1);
 
-    // Insert view before the tab to make sure it is there when the tab index
-    // changes (happens when first tab is inserted).
-    mViewStack->insertWidget(index, view);
     mTabBar->insertTab(index, tileset->name());
     mTabBar->setTabToolTip(index, tileset->fileName());
 
-    QString path = QLatin1String("TilesetDock/TilesetScale/") + tileset->name();
-    qreal scale = Preferences::instance()->value(path, 1).toReal();
-    view->zoomable()->setScale(scale);
-
     connect(tilesetDocument, &TilesetDocument::fileNameChanged,
             this, &TilesetDock::tilesetFileNameChanged);
-    connect(tilesetDocument, &TilesetDocument::tilesetChanged,
-            this, &TilesetDock::tilesetChanged);
-    connect(tilesetDocument, &TilesetDocument::tileImageSourceChanged,
-            this, &TilesetDock::tileImageSourceChanged);
-    connect(tilesetDocument, &TilesetDocument::tileAnimationChanged,
-            this, &TilesetDock::tileAnimationChanged);
-
-    connect(view, &TilesetView::clicked,
-            this, &TilesetDock::updateCurrentTiles);
-    connect(view, &TilesetView::swapTilesRequested,
-            this, &TilesetDock::swapTiles);
 }
 
 void TilesetDock::deleteTilesetView(int index)
 {
     TilesetDocument *tilesetDocument = mTilesetDocuments.at(index);
-    tilesetDocument->disconnect(this);
+    disconnect(tilesetDocument, &TilesetDocument::fileNameChanged,
+               this, &TilesetDock::tilesetFileNameChanged);
 
     Tileset *tileset = tilesetDocument->tileset().data();
-    TilesetView *view = tilesetViewAt(index);
 
-    QString path = QLatin1String("TilesetDock/TilesetScale/") + tileset->name();
-    auto preferences = Preferences::instance();
-    if (view->scale() != 1.0)
-        preferences->setValue(path, view->scale());
-    else
-        preferences->remove(path);
+    // The view is kept around, since the tileset is likely to be shown again
+    // when switching back to a map using it
+    if (TilesetView *view = tilesetViewAt(index))
+        saveTilesetScale(*tileset, view);
 
     mTilesets.remove(index);
-    mTilesetDocuments.removeAt(index);
-    delete view;                    // view needs to go before the tab
+    mTilesetDocuments.removeAt(index);  // needs to go before the tab
     mTabBar->removeTab(index);
 
     // Make the "New Tileset..." special tab reappear if there is no tileset open
@@ -626,16 +633,10 @@ void TilesetDock::moveTilesetView(int from, int to)
 
 void TilesetDock::tilesetChanged(Tileset *tileset)
 {
-    // Update the affected tileset model, if it exists
-    const int index = indexOf(mTilesets, tileset);
-    if (index < 0)
-        return;
-
-    TilesetView *view = tilesetViewAt(index);
-
-    if (TilesetModel *model = view->tilesetModel()) {
+    // Update the affected tileset view, if it exists
+    if (TilesetView *view = tilesetView(tileset)) {
         view->updateBackgroundColor();
-        model->tilesetChanged();
+        view->tilesetModel()->tilesetChanged();
     }
 }
 
@@ -644,9 +645,9 @@ void TilesetDock::tilesetChanged(Tileset *tileset)
  */
 void TilesetDock::removeTileset()
 {
-    const int currentIndex = mViewStack->currentIndex();
+    const int currentIndex = mTabBar->currentIndex();
     if (currentIndex != -1)
-        removeTilesetAt(mViewStack->currentIndex());
+        removeTilesetAt(currentIndex);
 }
 
 /**
@@ -819,12 +820,6 @@ void TilesetDock::onTabMoved(int from, int to)
 {
     mTilesets.move(from, to);
     mTilesetDocuments.move(from, to);
-
-    // Move the related tileset view
-    const QSignalBlocker blocker(mViewStack);
-    QWidget *widget = mViewStack->widget(from);
-    mViewStack->removeWidget(widget);
-    mViewStack->insertWidget(to, widget);
 }
 
 void TilesetDock::tabContextMenuRequested(const QPoint &pos)
@@ -921,12 +916,101 @@ QList<QObject *> TilesetDock::selectedTiles() const
 
 TilesetView *TilesetDock::currentTilesetView() const
 {
-    return static_cast<TilesetView *>(mViewStack->currentWidget());
+    return tilesetViewAt(mTabBar->currentIndex());
 }
 
+/**
+ * Returns the view for the tileset at the given tab \a index, or nullptr
+ * when it hasn't been created yet.
+ */
 TilesetView *TilesetDock::tilesetViewAt(int index) const
 {
-    return static_cast<TilesetView *>(mViewStack->widget(index));
+    if (index < 0 || index >= mTilesetDocuments.size())
+        return nullptr;
+
+    return mTilesetViews.value(mTilesetDocuments.at(index));
+}
+
+/**
+ * Returns the view for the given \a tileset, which may not have a tab
+ * currently. Returns nullptr when there is no view for this tileset.
+ */
+TilesetView *TilesetDock::tilesetView(Tileset *tileset) const
+{
+    for (auto it = mTilesetViews.begin(), it_end = mTilesetViews.end(); it != it_end; ++it)
+        if (it.key()->tileset() == tileset)
+            return it.value();
+
+    return nullptr;
+}
+
+/**
+ * Returns the view for the tileset at the given tab \a index, creating it
+ * when necessary. Marks the view as most recently used, releasing the least
+ * recently used views when there are more than MaxTilesetViews.
+ */
+TilesetView *TilesetDock::activateTilesetView(int index)
+{
+    TilesetDocument *tilesetDocument = mTilesetDocuments.at(index);
+    TilesetView *view = mTilesetViews.value(tilesetDocument);
+
+    if (view) {
+        mRecentlyUsedTilesetViews.removeOne(tilesetDocument);
+    } else {
+        Tileset *tileset = tilesetDocument->tileset().data();
+
+        view = new TilesetView;
+
+        qreal scale = Preferences::instance()->value(tilesetScalePath(*tileset), 1).toReal();
+        view->zoomable()->setScale(scale);
+
+        setupTilesetModel(view, tileset);
+
+        // These connections are tied to the view, since it may outlive the tab
+        connect(tilesetDocument, &TilesetDocument::tilesetChanged,
+                view, [this] (Tileset *changedTileset) { tilesetChanged(changedTileset); });
+        connect(tilesetDocument, &TilesetDocument::tileImageSourceChanged,
+                view, [this] (Tile *tile) { tileImageSourceChanged(tile); });
+        connect(tilesetDocument, &TilesetDocument::tileAnimationChanged,
+                view, [this] (Tile *tile) { tileAnimationChanged(tile); });
+        connect(tilesetDocument, &QObject::destroyed,
+                view, [=] { releaseTilesetView(tilesetDocument); });
+
+        connect(view, &TilesetView::clicked,
+                this, &TilesetDock::updateCurrentTiles);
+        connect(view, &TilesetView::swapTilesRequested,
+                this, &TilesetDock::swapTiles);
+
+        view->setTileUsage(mTileUsage);
+        view->setShowTileUsage(mShowTileUsage);
+        connect(view, &TilesetView::showTileUsageChanged,
+                this, &TilesetDock::setShowTileUsage);
+
+        mTilesetViews.insert(tilesetDocument, view);
+        mViewStack->addWidget(view);
+    }
+
+    mRecentlyUsedTilesetViews.prepend(tilesetDocument);
+
+    // Release the least recently used views, but never the displayed one
+    for (int i = mRecentlyUsedTilesetViews.size() - 1;
+         i > 0 && mRecentlyUsedTilesetViews.size() > MaxTilesetViews; --i) {
+        TilesetDocument *leastRecentlyUsed = mRecentlyUsedTilesetViews.at(i);
+        TilesetView *leastRecentlyUsedView = mTilesetViews.value(leastRecentlyUsed);
+        if (leastRecentlyUsedView == mViewStack->currentWidget())
+            continue;
+
+        saveTilesetScale(*leastRecentlyUsed->tileset(), leastRecentlyUsedView);
+        releaseTilesetView(leastRecentlyUsed);
+    }
+
+    return view;
+}
+
+void TilesetDock::releaseTilesetView(TilesetDocument *tilesetDocument)
+{
+    mRecentlyUsedTilesetViews.removeOne(tilesetDocument);
+    delete mTilesetViews.take(tilesetDocument);
 }
 
 void TilesetDock::setupTilesetModel(TilesetView *view, Tileset *tileset)
@@ -1064,12 +1148,8 @@ void TilesetDock::tilesetFileNameChanged(const QString &fileName)
 
 void TilesetDock::tileImageSourceChanged(Tile *tile)
 {
-    int tilesetIndex = mTilesets.indexOf(tile->tileset()->sharedPointer());
-    if (tilesetIndex != -1) {
-        TilesetView *view = tilesetViewAt(tilesetIndex);
-        if (TilesetModel *model = view->tilesetModel())
-            model->tileChanged(tile);
-    }
+    if (TilesetView *view = tilesetView(tile->tileset()))
+        view->tilesetModel()->tileChanged(tile);
 }
 
 void TilesetDock::tileAnimationChanged(Tile *tile)
@@ -1105,4 +1185,56 @@ void TilesetDock::swapTiles(Tile *tileA, Tile *tileB)
     undoStack->push(new SwapTiles(mMapDocument, tileA, tileB));
 }
 
+/**
+ * Sets whether the tileset views display how often each tile is used by the
+ * current map.
+ */
+void TilesetDock::setShowTileUsage(bool enabled)
+{
+    if (mShowTileUsage == enabled)
+        return;
+
+    mShowTileUsage = enabled;
+
+    for (TilesetView *view : qAsConst(mTilesetViews))
+        view->setShowTileUsage(enabled);
+
+    if (enabled) {
+        scheduleTileUsageUpdate();
+    } else {
+        mTileUsage.clear();
+        for (TilesetView *view : qAsConst(mTilesetViews))
+            view->setTileUsage(mTileUsage);
+    }
+}
+
+/**
+ * Schedules an update of the tile usage, so that it is computed only once
+ * for a number of changes.
+ */
+void TilesetDock::scheduleTileUsageUpdate()
+{
+    if (!mShowTileUsage || mTileUsageUpdateScheduled)
+        return;
+
+    mTileUsageUpdateScheduled = true;
+    QTimer::singleShot(0, this, &TilesetDock::updateTileUsage);
+}
+
+void TilesetDock::updateTileUsage()
+{
+    mTileUsageUpdateScheduled = false;
+
+    if (!mShowTileUsage)
+        return;
+
+    if (mMapDocument)
+        mTileUsage = mMapDocument->map()->tileUsage();
+    else
+        mTileUsage.clear();
+
+    for (TilesetView *view : qAsConst(mTilesetViews))
+        view->setTileUsage(mTileUsage);
+}
+
 #include "tilesetdock.moc"
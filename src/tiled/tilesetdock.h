@@ -26,6 +26,7 @@
 
 #include <QAbstractItemModel>
 #include <QDockWidget>
+#include <QHash>
 #include <QList>
 #include <QMap>
 
@@ -145,6 +146,10 @@ private:
 
     void swapTiles(Tile *tileA, Tile *tileB);
 
+    void setShowTileUsage(bool enabled);
+    void scheduleTileUsageUpdate();
+    void updateTileUsage();
+
     void selectTiles(const QList<Tile *> &tiles);
     void setCurrentTile(Tile *tile);
     void setCurrentTiles(TileLayer *tiles);
@@ -162,6 +167,9 @@ private:
 
     TilesetView *currentTilesetView() const;
     TilesetView *tilesetViewAt(int index) const;
+    TilesetView *tilesetView(Tileset *tileset) const;
+    TilesetView *activateTilesetView(int index);
+    void releaseTilesetView(TilesetDocument *tilesetDocument);
 
     void createTilesetView(int index, TilesetDocument *tilesetDocument);
     void deleteTilesetView(int index);
@@ -175,6 +183,11 @@ private:
     QList<TilesetDocument *> mTilesetDocuments;
     TilesetDocumentsFilterModel *mTilesetDocumentsFilterModel;
 
+    // Views are created when their tab is first activated and are kept
+    // around for switching between maps, up to MaxTilesetViews
+    QHash<TilesetDocument *, TilesetView *> mTilesetViews;
+    QList<TilesetDocument *> mRecentlyUsedTilesetViews;
+
     QTabBar *mTabBar;
     QStackedWidget *mSuperViewStack;
     QStackedWidget *mViewStack;
@@ -200,6 +213,10 @@ private:
 
     bool mEmittingStampCaptured;
     bool mSynchronizingSelection;
+
+    bool mShowTileUsage = false;
+    bool mTileUsageUpdateScheduled = false;
+    QHash<const Tile *, int> mTileUsage;
 };
 
 } // namespace Tiled
@@ -81,6 +81,9 @@ private:
                          const Tile *tile,
                          QRect targetRect,
                          const QModelIndex &index) const;
+    void drawTileUsageOverlay(QPainter *painter,
+                              const Tile *tile,
+                              QRect targetRect) const;
 
     TilesetView *mTilesetView;
 };
@@ -605,6 +608,34 @@ void TileDelegate::paint(QPainter *painter,
 
     if (mTilesetView->isEditWangSet())
         drawWangOverlay(painter, tile, targetRect, index);
+
+    if (mTilesetView->showTileUsage())
+        drawTileUsageOverlay(painter, tile, targetRect);
+}
+
+/**
+ * Shades unused tiles and tints used tiles with a color that is stronger the
+ * more often the tile is used.
+ */
+void TileDelegate::drawTileUsageOverlay(QPainter *painter,
+                                        const Tile *tile,
+                                        QRect targetRect) const
+{
+    const int usage = mTilesetView->tileUsage(tile);
+    const int maxUsage = mTilesetView->maxTileUsage();
+
+    painter->save();
+
+    if (usage == 0) {
+        painter->setOpacity(0.6);
+        painter->fillRect(targetRect, Qt::black);
+    } else {
+        const qreal heat = qreal(usage) / qMax(1, maxUsage);
+        painter->setOpacity(0.2 + 0.4 * heat);
+        painter->fillRect(targetRect, QColor(255, 64, 0));
+    }
+
+    painter->restore();
 }
 
 QSize TileDelegate::sizeHint(const QStyleOptionViewItem & /* option */,
@@ -877,6 +908,36 @@ void TilesetView::setMarkAnimatedTiles(bool enabled)
     viewport()->update();
 }
 
+/**
+ * Sets whether the tile usage is displayed as an overlay. The usage needs to
+ * be provided by setTileUsage().
+ */
+void TilesetView::setShowTileUsage(bool enabled)
+{
+    if (mShowTileUsage == enabled)
+        return;
+
+    mShowTileUsage = enabled;
+    viewport()->update();
+
+    emit showTileUsageChanged(enabled);
+}
+
+/**
+ * Sets the number of times each tile is used, as displayed when
+ * showTileUsage() is enabled.
+ */
+void TilesetView::setTileUsage(const QHash<const Tile *, int> &usage)
+{
+    mTileUsage = usage;
+    mMaxTileUsage = 0;
+    for (int count : usage)
+        mMaxTileUsage = std::max(mMaxTileUsage, count);
+
+    if (mShowTileUsage)
+        viewport()->update();
+}
+
 bool TilesetView::event(QEvent *event)
 {
     if (event->type() == QEvent::Gesture) {
@@ -1342,6 +1403,13 @@ void TilesetView::contextMenuEvent(QContextMenuEvent *event)
         menu.addSeparator();
     }
 
+    if (!mTilesetDocument) {
+        QAction *toggleTileUsage = menu.addAction(tr("Show Tile &Usage"));
+        toggleTileUsage->setCheckable(true);
+        toggleTileUsage->setChecked(mShowTileUsage);
+        connect(toggleTileUsage, &QAction::toggled, this, &TilesetView::setShowTileUsage);
+    }
+
     QAction *toggleGrid = menu.addAction(tr("Show &Grid"));
     toggleGrid->setCheckable(true);
     toggleGrid->setChecked(mDrawGrid);
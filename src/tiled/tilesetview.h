@@ -23,6 +23,7 @@
 #include "tilesetmodel.h"
 #include "wangset.h"
 
+#include <QHash>
 #include <QTableView>
 
 namespace Tiled {
@@ -81,6 +82,13 @@ public:
     void setMarkAnimatedTiles(bool enabled);
     bool markAnimatedTiles() const;
 
+    void setShowTileUsage(bool enabled);
+    bool showTileUsage() const { return mShowTileUsage; }
+
+    void setTileUsage(const QHash<const Tile*, int> &usage);
+    int tileUsage(const Tile *tile) const { return mTileUsage.value(tile); }
+    int maxTileUsage() const { return mMaxTileUsage; }
+
     /**
      * Returns whether terrain editing is enabled.
      * \sa terrainId
@@ -136,6 +144,7 @@ signals:
     void wangIdUsedChanged(WangId wangId);
     void currentWangIdChanged(WangId wangId);
     void swapTilesRequested(Tile *tileA, Tile *tileB);
+    void showTileUsageChanged(bool enabled);
 
 protected:
     bool event(QEvent *event) override;
@@ -184,6 +193,9 @@ private:
     TilesetDocument *mTilesetDocument = nullptr;
     bool mDrawGrid;
     bool mMarkAnimatedTiles = true;
+    bool mShowTileUsage = false;
+    QHash<const Tile*, int> mTileUsage;
+    int mMaxTileUsage = 0;
     bool mEditTerrain = false;
     bool mEditWangSet = false;
     WrapBehavior mWrapBehavior = WrapDefault;
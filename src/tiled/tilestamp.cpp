@@ -26,10 +26,13 @@
 #include "varianttomapconverter.h"
 
 #include <QDebug>
+#include <QHash>
 #include <QJsonArray>
 
 #include <qtcompat_p.h>
 
+#include <algorithm>
+
 namespace Tiled {
 
 class TileStampData : public QSharedData
@@ -39,14 +42,29 @@ public:
     TileStampData(const TileStampData &other);
     ~TileStampData();
 
+    bool canCacheTransforms() const;
+    void detachTransforms();
+
     int quickStampIndex;
     QString name;
     QString fileName;
     QVector<TileStampVariation> variations;
+
+    RandomPicker<int> variationPicker;
+    bool variationPickerValid;
+
+    // The flipped and rotated versions of a stamp are cached by the original
+    // stamp, by their transform relative to the original
+    QHash<int, QExplicitlySharedDataPointer<TileStampData>> transformedStamps;
+    TileStampData *original;
+    int transform;
 };
 
 TileStampData::TileStampData()
     : quickStampIndex(-1)
+    , variationPickerValid(false)
+    , original(nullptr)
+    , transform(0)
 {}
 
 TileStampData::TileStampData(const TileStampData &other)
@@ -55,18 +73,86 @@ TileStampData::TileStampData(const TileStampData &other)
     , name(other.name)
     , fileName()                        // not copied
     , variations(other.variations)
+    , variationPickerValid(false)
+    , original(nullptr)                 // not copied
+    , transform(0)
 {
-    // deep-copy the map data
+    // deep-copy the map data (the tile layer chunks are implicitly shared)
     for (TileStampVariation &variation : variations)
         variation.map = variation.map->clone().release();
 }
 
 TileStampData::~TileStampData()
 {
+    // The transformed stamps may outlive the original
+    for (const auto &transformed : qAsConst(transformedStamps)) {
+        transformed->original = nullptr;
+        transformed->transform = 0;
+    }
+
     for (const TileStampVariation &variation : qAsConst(variations))
         delete variation.map;
 }
 
+/**
+ * Transforms are only cached when flipping and rotating behave like they do
+ * on a square grid, so that they can be combined. This is not the case for
+ * staggered and hexagonal maps.
+ */
+bool TileStampData::canCacheTransforms() const
+{
+    return std::none_of(variations.begin(), variations.end(),
+                        [] (const TileStampVariation &variation) {
+        return variation.map->isStaggered();
+    });
+}
+
+/**
+ * Should be called before the stamp changes, since it will no longer be a
+ * transformed version of its original, nor will its cached transforms
+ * match.
+ */
+void TileStampData::detachTransforms()
+{
+    if (original) {
+        // Safe, since the caller holds another reference to this stamp
+        original->transformedStamps.remove(transform);
+        original = nullptr;
+        transform = 0;
+    }
+
+    for (const auto &transformed : qAsConst(transformedStamps)) {
+        transformed->original = nullptr;
+        transformed->transform = 0;
+    }
+    transformedStamps.clear();
+}
+
+
+/*
+ * A transform is an element of the symmetry group of the square, stored as
+ * (rotation << 1) | flip. It means flipping horizontally when the flip bit
+ * is set, followed by the given number of clockwise quarter turns.
+ */
+static int rotateTransform(int transform, RotateDirection direction)
+{
+    const int rotation = transform >> 1;
+    const int flip = transform & 1;
+    const int turns = direction == RotateRight ? 1 : 3;
+    return (((rotation + turns) & 3) << 1) | flip;
+}
+
+static int flipTransform(int transform, FlipDirection direction)
+{
+    // Flipping horizontally inverts the preceding rotation, while flipping
+    // vertically is the same as flipping horizontally and turning twice.
+    const int rotation = transform >> 1;
+    const int flip = transform & 1;
+    const int flippedRotation = direction == FlipHorizontally ? -rotation
+                                                              : 2 - rotation;
+    return ((flippedRotation & 3) << 1) | (flip ^ 1);
+}
+
 
 TileStamp::TileStamp()
     : d(new TileStampData)
@@ -87,6 +173,11 @@ TileStamp::TileStamp(const TileStamp &other)
 {
 }
 
+TileStamp::TileStamp(TileStampData *data)
+    : d(data)
+{
+}
+
 TileStamp &TileStamp::operator=(const TileStamp &other)
 {
     d = other.d;
@@ -110,6 +201,7 @@ QString TileStamp::name() const
 
 void TileStamp::setName(const QString &name)
 {
+    d->detachTransforms();
     d->name = name;
 }
 
@@ -120,6 +212,7 @@ QString TileStamp::fileName() const
 
 void TileStamp::setFileName(const QString &fileName)
 {
+    d->detachTransforms();
     d->fileName = fileName;
 }
 
@@ -130,7 +223,9 @@ qreal TileStamp::probability(int index) const
 
 void TileStamp::setProbability(int index, qreal probability)
 {
+    d->detachTransforms();
     d->variations[index].probability = probability;
+    d->variationPickerValid = false;
 }
 
 QSize TileStamp::maxSize() const
@@ -154,7 +249,9 @@ const QVector<TileStampVariation> &TileStamp::variations() const
 void TileStamp::addVariation(std::unique_ptr<Map> map, qreal probability)
 {
     Q_ASSERT(map);
+    d->detachTransforms();
     d->variations.append(TileStampVariation(map.release(), probability));
+    d->variationPickerValid = false;
 }
 
 /**
@@ -163,6 +260,8 @@ void TileStamp::addVariation(std::unique_ptr<Map> map, qreal probability)
  */
 Map *TileStamp::takeVariation(int index)
 {
+    d->detachTransforms();
+    d->variationPickerValid = false;
     return d->variations.takeAt(index).map;
 }
 
@@ -181,6 +280,7 @@ int TileStamp::quickStampIndex() const
 
 void TileStamp::setQuickStampIndex(int quickStampIndex)
 {
+    d->detachTransforms();
     d->quickStampIndex = quickStampIndex;
 }
 
@@ -188,11 +288,15 @@ const TileStampVariation &TileStamp::randomVariation() const
 {
     Q_ASSERT(!d->variations.isEmpty());
 
-    RandomPicker<const TileStampVariation *> randomPicker;
-    for (const TileStampVariation &variation : qAsConst(d->variations))
-        randomPicker.add(&variation, variation.probability);
+    // The picker is kept until the variations change
+    if (!d->variationPickerValid) {
+        d->variationPicker.clear();
+        for (int i = 0; i < d->variations.size(); ++i)
+            d->variationPicker.add(i, d->variations.at(i).probability);
+        d->variationPickerValid = true;
+    }
 
-    return *randomPicker.pick();
+    return d->variations.at(d->variationPicker.pick());
 }
 
 /**
@@ -201,7 +305,13 @@ const TileStampVariation &TileStamp::randomVariation() const
  */
 TileStamp TileStamp::flipped(FlipDirection direction) const
 {
-    TileStamp flipped(*this);
+    const int transform = flipTransform(d->transform, direction);
+
+    TileStamp flipped = cachedTransform(transform);
+    if (!flipped.isEmpty())
+        return flipped;
+
+    flipped = *this;
     flipped.d.detach();
 
     for (const TileStampVariation &variation : flipped.variations()) {
@@ -236,6 +346,7 @@ TileStamp TileStamp::flipped(FlipDirection direction) const
         }
     }
 
+    cacheTransform(transform, flipped);
     return flipped;
 }
 
@@ -245,7 +356,13 @@ TileStamp TileStamp::flipped(FlipDirection direction) const
  */
 TileStamp TileStamp::rotated(RotateDirection direction) const
 {
-    TileStamp rotated(*this);
+    const int transform = rotateTransform(d->transform, direction);
+
+    TileStamp rotated = cachedTransform(transform);
+    if (!rotated.isEmpty())
+        return rotated;
+
+    rotated = *this;
     rotated.d.detach();
 
     for (const TileStampVariation &variation : rotated.variations()) {
@@ -273,9 +390,44 @@ TileStamp TileStamp::rotated(RotateDirection direction) const
         variation.map->setHeight(rotatedSize.height());
     }
 
+    cacheTransform(transform, rotated);
     return rotated;
 }
 
+/**
+ * Returns the version of the original stamp with the given \a transform
+ * applied, when it is still cached. Returns an empty stamp otherwise.
+ */
+TileStamp TileStamp::cachedTransform(int transform) const
+{
+    if (!d->canCacheTransforms())
+        return TileStamp();
+
+    TileStampData *original = d->original ? d->original : d.data();
+    if (transform == 0)
+        return TileStamp(original);
+
+    if (TileStampData *transformed = original->transformedStamps.value(transform).data())
+        return TileStamp(transformed);
+
+    return TileStamp();
+}
+
+/**
+ * Remembers the given \a stamp as the version of the original stamp with
+ * the given \a transform applied.
+ */
+void TileStamp::cacheTransform(int transform, const TileStamp &stamp) const
+{
+    if (transform == 0 || !d->canCacheTransforms())
+        return;
+
+    TileStampData *original = d->original ? d->original : d.data();
+    original->transformedStamps.insert(transform, stamp.d);
+    stamp.d->original = original;
+    stamp.d->transform = transform;
+}
+
 /**
  * Clones the tile stamp. Changes made to the clone do not affect the original
  * stamp.
@@ -97,6 +97,11 @@ public:
                               const QDir &mapDir);
 
 private:
+    explicit TileStamp(TileStampData *data);
+
+    TileStamp cachedTransform(int transform) const;
+    void cacheTransform(int transform, const TileStamp &stamp) const;
+
     QExplicitlySharedDataPointer<TileStampData> d;
 };
 
@@ -31,6 +31,43 @@
 
 using namespace Tiled;
 
+/**
+ * Returns whether the given file has the given \a extension, or is an .xml
+ * file with a root element named \a rootElement.
+ *
+ * The root element is looked up in the \a header when given, and only when
+ * it does not fit in the header is the whole file read.
+ */
+static bool supportsXmlFile(const QString &fileName,
+                            const QByteArray *header,
+                            QLatin1String extension,
+                            QLatin1String rootElement)
+{
+    if (fileName.endsWith(extension, Qt::CaseInsensitive))
+        return true;
+
+    if (!fileName.endsWith(QLatin1String(".xml"), Qt::CaseInsensitive))
+        return false;
+
+    const QByteArray data = header ? *header : FileFormat::readFileHeader(fileName);
+
+    QXmlStreamReader xml(data);
+    if (xml.readNextStartElement())
+        return xml.name() == rootElement;
+
+    // The root element may be preceded by comments longer than the header
+    if (xml.error() != QXmlStreamReader::PrematureEndOfDocument ||
+            data.size() < FileFormat::FileHeaderSize)
+        return false;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return false;
+
+    QXmlStreamReader fileXml(&file);
+    return fileXml.readNextStartElement() && fileXml.name() == rootElement;
+}
+
 TmxMapFormat::TmxMapFormat(QObject *parent)
     : MapFormat(parent)
 {
@@ -91,22 +128,15 @@ std::unique_ptr<Map> TmxMapFormat::fromByteArray(const QByteArray &data)
 
 bool TmxMapFormat::supportsFile(const QString &fileName) const
 {
-    if (fileName.endsWith(QLatin1String(".tmx"), Qt::CaseInsensitive))
-        return true;
-
-    if (fileName.endsWith(QLatin1String(".xml"), Qt::CaseInsensitive)) {
-        QFile file(fileName);
-
-        if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            QXmlStreamReader xml;
-            xml.setDevice(&file);
-
-            if (xml.readNextStartElement() && xml.name() == QLatin1String("map"))
-                return true;
-        }
-    }
+    return supportsXmlFile(fileName, nullptr,
+                           QLatin1String(".tmx"), QLatin1String("map"));
+}
 
-    return false;
+bool TmxMapFormat::supportsFileHeader(const QString &fileName,
+                                      const QByteArray &header) const
+{
+    return supportsXmlFile(fileName, &header,
+                           QLatin1String(".tmx"), QLatin1String("map"));
 }
 
 
@@ -143,22 +173,15 @@ bool TsxTilesetFormat::write(const Tileset &tileset, const QString &fileName, Op
 
 bool TsxTilesetFormat::supportsFile(const QString &fileName) const
 {
-    if (fileName.endsWith(QLatin1String(".tsx"), Qt::CaseInsensitive))
-        return true;
-
-    if (fileName.endsWith(QLatin1String(".xml"), Qt::CaseInsensitive)) {
-        QFile file(fileName);
-
-        if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            QXmlStreamReader xml;
-            xml.setDevice(&file);
-
-            if (xml.readNextStartElement() && xml.name() == QLatin1String("tileset"))
-                return true;
-        }
-    }
+    return supportsXmlFile(fileName, nullptr,
+                           QLatin1String(".tsx"), QLatin1String("tileset"));
+}
 
-    return false;
+bool TsxTilesetFormat::supportsFileHeader(const QString &fileName,
+                                          const QByteArray &header) const
+{
+    return supportsXmlFile(fileName, &header,
+                           QLatin1String(".tsx"), QLatin1String("tileset"));
 }
 
 XmlObjectTemplateFormat::XmlObjectTemplateFormat(QObject *parent)
@@ -193,20 +216,13 @@ bool XmlObjectTemplateFormat::write(const ObjectTemplate *objectTemplate, const
 
 bool XmlObjectTemplateFormat::supportsFile(const QString &fileName) const
 {
-    if (fileName.endsWith(QLatin1String(".tx"), Qt::CaseInsensitive))
-        return true;
-
-    if (fileName.endsWith(QLatin1String(".xml"), Qt::CaseInsensitive)) {
-        QFile file(fileName);
-
-        if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            QXmlStreamReader xml;
-            xml.setDevice(&file);
-
-            if (xml.readNextStartElement() && xml.name() == QLatin1String("template"))
-                return true;
-        }
-    }
+    return supportsXmlFile(fileName, nullptr,
+                           QLatin1String(".tx"), QLatin1String("template"));
+}
 
-    return false;
+bool XmlObjectTemplateFormat::supportsFileHeader(const QString &fileName,
+                                                 const QByteArray &header) const
+{
+    return supportsXmlFile(fileName, &header,
+                           QLatin1String(".tx"), QLatin1String("template"));
 }
@@ -67,6 +67,8 @@ public:
     QString shortName() const override { return QLatin1String("tmx"); }
 
     bool supportsFile(const QString &fileName) const override;
+    bool supportsFileHeader(const QString &fileName,
+                            const QByteArray &header) const override;
 
     QString errorString() const override { return mError; }
 
@@ -95,6 +97,8 @@ public:
     QString shortName() const override { return QLatin1String("tsx"); }
 
     bool supportsFile(const QString &fileName) const override;
+    bool supportsFileHeader(const QString &fileName,
+                            const QByteArray &header) const override;
 
     QString errorString() const override { return mError; }
 
@@ -122,6 +126,8 @@ public:
     QString shortName() const override { return QLatin1String("tx"); }
 
     bool supportsFile(const QString &fileName) const override;
+    bool supportsFileHeader(const QString &fileName,
+                            const QByteArray &header) const override;
 
     QString errorString() const override { return mError; }
 
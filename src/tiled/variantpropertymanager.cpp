@@ -47,7 +47,7 @@ MapObject *DisplayObjectRef::object() const
 {
     if (!mapDocument || ref.id <= 0)
         return nullptr;
-    return mapDocument->map()->findObjectById(ref.id);
+    return mapDocument->objectReferences().findObjectById(ref.id);
 }
 
 
@@ -20,7 +20,6 @@
 
 #include "wangfiller.h"
 
-#include "randompicker.h"
 #include "staggeredrenderer.h"
 #include "tilelayer.h"
 #include "wangset.h"
@@ -50,6 +49,7 @@ WangFiller::WangFiller(WangSet *wangSet,
 void WangFiller::setWangSet(WangSet *wangSet)
 {
     mWangSet = wangSet;
+    mWangTilePickers.clear();
 }
 
 static void getSurroundingPoints(QPoint point,
@@ -87,17 +87,15 @@ Cell WangFiller::findFittingCell(const TileLayer &back,
 {
     Q_ASSERT(mWangSet);
 
-    QList<WangTile> wangTilesList = mWangSet->findMatchingWangTiles(wangIdFromSurroundings(back,
-                                                                                           front,
-                                                                                           fillRegion,
-                                                                                           point));
-    RandomPicker<WangTile> wangTiles;
-
-    for (const WangTile &wangTile : wangTilesList)
-        wangTiles.add(wangTile, mWangSet->wangTileProbability(wangTile));
+    const RandomPicker<WangTile> &matchingWangTiles = wangTilePicker(wangIdFromSurroundings(back,
+                                                                                            front,
+                                                                                            fillRegion,
+                                                                                            point));
 
     WangTile wangTile;
     if (!mWangSet->isComplete()) {
+        RandomPicker<WangTile> wangTiles = matchingWangTiles;
+
         // goes through all adjacent, empty tiles and sees if the current wangTile
         // allows them to have at least one fill option.
         while (!wangTiles.isEmpty()) {
@@ -132,8 +130,8 @@ Cell WangFiller::findFittingCell(const TileLayer &back,
             if (!continueFlag)
                 break;
         }
-    } else if (!wangTiles.isEmpty()) {
-        wangTile = wangTiles.pick();
+    } else if (!matchingWangTiles.isEmpty()) {
+        wangTile = matchingWangTiles.pick();
     }
 
     return wangTile.makeCell();
@@ -183,6 +181,8 @@ std::unique_ptr<TileLayer> WangFiller::fillRegion(const TileLayer &back,
         }
     }
 
+    const bool isComplete = mWangSet->isComplete();
+
 #if QT_VERSION < 0x050800
     for (const QRect &rect : rects) {
 #else
@@ -193,17 +193,16 @@ std::unique_ptr<TileLayer> WangFiller::fillRegion(const TileLayer &back,
                 QPoint currentPoint(x, y);
                 int currentIndex = (currentPoint.y() - tileLayer->y()) * tileLayer->width() + (currentPoint.x() - tileLayer->x());
 
-                QList<WangTile> wangTilesList = mWangSet->findMatchingWangTiles(wangIds[currentIndex]);
-                RandomPicker<WangTile> wangTiles;
-
-                for (const WangTile &wangTile : wangTilesList)
-                    wangTiles.add(wangTile, mWangSet->wangTileProbability(wangTile));
+                const RandomPicker<WangTile> &matchingWangTiles = wangTilePicker(wangIds[currentIndex]);
+                RandomPicker<WangTile> wangTiles = matchingWangTiles;
 
                 while (!wangTiles.isEmpty()) {
-                    WangTile wangTile = wangTiles.take();
+                    // For complete sets the first tile is always used, so it
+                    // can be picked from the cached picker directly
+                    WangTile wangTile = isComplete ? matchingWangTiles.pick() : wangTiles.take();
 
                     bool fill = true;
-                    if (!mWangSet->isComplete()) {
+                    if (!isComplete) {
                         QPoint adjacentPoints[8];
                         getSurroundingPoints(currentPoint, mStaggeredRenderer, mStaggerAxis, adjacentPoints);
 
@@ -249,6 +248,21 @@ std::unique_ptr<TileLayer> WangFiller::fillRegion(const TileLayer &back,
     return tileLayer;
 }
 
+const RandomPicker<WangTile> &WangFiller::wangTilePicker(WangId wangId) const
+{
+    auto it = mWangTilePickers.find(wangId);
+    if (it == mWangTilePickers.end()) {
+        RandomPicker<WangTile> wangTiles;
+
+        const QList<WangTile> wangTilesList = mWangSet->findMatchingWangTiles(wangId);
+        for (const WangTile &wangTile : wangTilesList)
+            wangTiles.add(wangTile, mWangSet->wangTileProbability(wangTile));
+
+        it = mWangTilePickers.insert(wangId, wangTiles);
+    }
+    return it.value();
+}
+
 const Cell &WangFiller::getCell(const TileLayer &back,
                                 const TileLayer &front,
                                 const QRegion &fillRegion,
@@ -21,8 +21,10 @@
 #pragma once
 
 #include "map.h"
+#include "randompicker.h"
 #include "wangset.h"
 
+#include <QHash>
 #include <QList>
 #include <QMap>
 #include <QPoint>
@@ -101,9 +103,16 @@ private:
                                   const QRegion &fillRegion,
                                   QPoint point) const;
 
+    /**
+     * Returns a picker for the Wang tiles matching the given \a wangId.
+     * Pickers are cached, since many cells usually share the same \a wangId.
+     */
+    const RandomPicker<WangTile> &wangTilePicker(WangId wangId) const;
+
     WangSet *mWangSet;
     StaggeredRenderer *mStaggeredRenderer;
     Map::StaggerAxis mStaggerAxis;
+    mutable QHash<unsigned, RandomPicker<WangTile>> mWangTilePickers;
 };
 
 } // namespace Tiled
@@ -197,6 +197,8 @@ ApplicationWindow {
                 text: {
                     if (mapLoader.status === Tiled.MapLoader.Null) {
                         qsTr("No map file loaded")
+                    } else if (mapLoader.status === Tiled.MapLoader.Loading) {
+                        qsTr("Loading map... %1%").arg(Math.round(mapLoader.progress * 100))
                     } else if (mapLoader.status === Tiled.MapLoader.Error) {
                         mapLoader.error
                     } else {
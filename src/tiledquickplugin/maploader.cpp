@@ -20,22 +20,277 @@
 
 #include "maploader.h"
 
+#include "imagecache.h"
+#include "imagelayer.h"
+#include "layer.h"
 #include "map.h"
 #include "mapreader.h"
+#include "objecttemplate.h"
+#include "tile.h"
 #include "tiled.h"
 #include "tileset.h"
 
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <functional>
+
 using namespace TiledQuick;
 
+namespace TiledQuick {
+
+/**
+ * The result of loading a map on the worker thread. The map is shared, so
+ * that it is deleted also when the result never reaches the MapLoader that
+ * requested it.
+ */
+struct LoadedMap
+{
+    int requestId = 0;
+    std::shared_ptr<Tiled::Map> map;
+    QVector<std::shared_ptr<Tiled::ObjectTemplate>> objectTemplates;
+    QVector<Tiled::SharedTileset> tilesets;     // including those of templates
+    QHash<const Tiled::Tileset*, QImage> tilesetImages;
+    QString error;
+};
+
+/**
+ * Reads maps on behalf of a MapLoader. Lives on the loader's worker thread.
+ */
+class MapLoaderWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    void setLatestRequestId(int requestId) { mLatestRequestId.store(requestId); }
+
+    void load(int requestId, const QString &fileName);
+
+signals:
+    void progressChanged(int requestId, qreal progress);
+    void loaded(const LoadedMap &loadedMap);
+
+private:
+    QAtomicInt mLatestRequestId;
+};
+
+} // namespace TiledQuick
+
+Q_DECLARE_METATYPE(TiledQuick::LoadedMap)
+
+namespace {
+
+/**
+ * The map reader relies on caches that are not thread-safe, like the image
+ * cache, so only one map is read at a time.
+ */
+QMutex readMutex;
+
+/**
+ * The decoded tileset images of the maps currently held by any MapLoader.
+ */
+QMutex tilesetImagesMutex;
+QHash<const Tiled::Tileset*, QImage> tilesetImages;
+
+/**
+ * A file that reports how much of it has been read.
+ */
+class ProgressFile : public QFile
+{
+public:
+    ProgressFile(const QString &fileName, std::function<void(qreal)> callback)
+        : QFile(fileName)
+        , mCallback(std::move(callback))
+    {}
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override
+    {
+        const qint64 read = QFile::readData(data, maxSize);
+        if (read > 0 && size() > 0) {
+            mBytesRead += read;
+            const qreal progress = qreal(mBytesRead) / size();
+
+            // Avoid flooding the event queue with tiny progress updates
+            if (progress - mReportedProgress >= 0.01) {
+                mReportedProgress = progress;
+                mCallback(qMin(progress, qreal(1.0)));
+            }
+        }
+        return read;
+    }
+
+private:
+    std::function<void(qreal)> mCallback;
+    qint64 mBytesRead = 0;
+    qreal mReportedProgress = 0.0;
+};
+
+/**
+ * A map reader that avoids the TilesetManager and the TemplateManager, which
+ * are not thread-safe, by reading external tilesets and templates directly.
+ * Images are not loaded, since QPixmap can only be used on the GUI thread.
+ *
+ * The templates are owned by the reader until they are taken along with the
+ * map.
+ */
+class WorkerMapReader : public Tiled::MapReader
+{
+public:
+    WorkerMapReader()
+    {
+        setLoadImages(false);
+    }
+
+    QVector<std::shared_ptr<Tiled::ObjectTemplate>> takeObjectTemplates()
+    {
+        QVector<std::shared_ptr<Tiled::ObjectTemplate>> objectTemplates;
+        for (auto &objectTemplate : mObjectTemplates)
+            objectTemplates.append(std::move(objectTemplate));
+        mObjectTemplates.clear();
+        return objectTemplates;
+    }
+
+protected:
+    Tiled::SharedTileset readExternalTileset(const QString &source,
+                                             QString *error) override
+    {
+        Tiled::MapReader reader;
+        reader.setLoadImages(false);
+        Tiled::SharedTileset tileset = reader.readTileset(source);
+        if (!tileset)
+            *error = reader.errorString();
+        return tileset;
+    }
+
+    Tiled::ObjectTemplate *loadObjectTemplate(const QString &fileName) override
+    {
+        std::shared_ptr<Tiled::ObjectTemplate> &objectTemplate = mObjectTemplates[fileName];
+
+        if (!objectTemplate) {
+            // A separate reader is used, since this one is busy with the map
+            WorkerMapReader reader;
+            objectTemplate = reader.readObjectTemplate(fileName);
+
+            // Like the TemplateManager, keep an empty template for broken
+            // references
+            if (!objectTemplate)
+                objectTemplate = std::make_shared<Tiled::ObjectTemplate>(fileName);
+        }
+
+        return objectTemplate.get();
+    }
+
+private:
+    QHash<QString, std::shared_ptr<Tiled::ObjectTemplate>> mObjectTemplates;
+};
+
+} // anonymous namespace
+
+
+void MapLoaderWorker::load(int requestId, const QString &fileName)
+{
+    // Skip requests that were already superseded while queued
+    if (requestId != mLatestRequestId.load())
+        return;
+
+    LoadedMap loadedMap;
+    loadedMap.requestId = requestId;
+
+    QMutexLocker locker(&readMutex);
+
+    ProgressFile file(fileName, [=] (qreal progress) {
+        emit progressChanged(requestId, progress);
+    });
+
+    std::unique_ptr<Tiled::Map> map;
+
+    if (!file.exists()) {
+        loadedMap.error = QCoreApplication::translate("MapReader", "File not found: %1").arg(fileName);
+    } else if (!file.open(QFile::ReadOnly | QFile::Text)) {
+        loadedMap.error = QCoreApplication::translate("MapReader", "Unable to read file: %1").arg(fileName);
+    } else {
+        WorkerMapReader mapReader;
+        map = mapReader.readMap(&file, QFileInfo(fileName).absolutePath());
+        if (map)
+            loadedMap.objectTemplates = mapReader.takeObjectTemplates();
+        else
+            loadedMap.error = mapReader.errorString();
+    }
+
+    if (map) {
+        loadedMap.tilesets = map->tilesets();
+
+        // Tilesets referenced only by templates are not part of the map
+        for (const auto &objectTemplate : qAsConst(loadedMap.objectTemplates)) {
+            const Tiled::SharedTileset &tileset = objectTemplate->tileset();
+            if (tileset && !loadedMap.tilesets.contains(tileset))
+                loadedMap.tilesets.append(tileset);
+        }
+
+        // Prepare the tileset images in the format used for textures, so that
+        // only the upload remains to be done by the render thread.
+        for (const Tiled::SharedTileset &tileset : qAsConst(loadedMap.tilesets)) {
+            if (tileset->isCollection())
+                continue;
+
+            const QString imagePath(Tiled::urlToLocalFileOrQrc(tileset->imageSource()));
+            const QImage image = Tiled::ImageCache::loadImage(imagePath);
+            if (!image.isNull()) {
+                loadedMap.tilesetImages.insert(tileset.data(),
+                                               image.convertToFormat(QImage::Format_ARGB32_Premultiplied));
+            }
+        }
+    }
+
+    locker.unlock();
+
+    loadedMap.map = std::move(map);
+    emit loaded(loadedMap);
+}
+
+
 MapLoader::MapLoader(QObject *parent)
     : QObject(parent)
     , m_map(nullptr)
     , m_status(Null)
+    , m_progress(0.0)
+    , m_requestId(0)
+    , m_worker(new MapLoaderWorker)
 {
+    qRegisterMetaType<LoadedMap>();
+
+    m_worker->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+    connect(this, &MapLoader::loadRequested, m_worker, &MapLoaderWorker::load);
+    connect(m_worker, &MapLoaderWorker::progressChanged, this, &MapLoader::loadProgress);
+    connect(m_worker, &MapLoaderWorker::loaded, this, &MapLoader::mapLoaded);
+    m_thread.start();
 }
 
 MapLoader::~MapLoader()
 {
+    m_worker->setLatestRequestId(-1);
+    m_thread.quit();
+    m_thread.wait();
+
+    QMutexLocker locker(&tilesetImagesMutex);
+    for (const Tiled::Tileset *tileset : qAsConst(m_tilesets))
+        tilesetImages.remove(tileset);
+}
+
+/**
+ * Returns the decoded image of the given \a tileset, if it belongs to a map
+ * loaded by a MapLoader. Can be called from the render thread.
+ */
+QImage MapLoader::tilesetImage(const Tiled::Tileset *tileset)
+{
+    QMutexLocker locker(&tilesetImagesMutex);
+    return tilesetImages.value(tileset);
 }
 
 void MapLoader::setSource(const QUrl &source)
@@ -44,27 +299,131 @@ void MapLoader::setSource(const QUrl &source)
         return;
 
     m_source = source;
+    m_worker->setLatestRequestId(++m_requestId);
+
+    emit sourceChanged(source);
+
+    if (source.isEmpty()) {
+        setMap(nullptr, QVector<std::shared_ptr<Tiled::ObjectTemplate>>(),
+               QHash<const Tiled::Tileset*, QImage>());
+        setError(QString());
+        setProgress(0.0);
+        setStatus(Null);
+        return;
+    }
+
+    setProgress(0.0);
+    setStatus(Loading);
+
+    emit loadRequested(m_requestId, Tiled::urlToLocalFileOrQrc(source));
+}
+
+void MapLoader::mapLoaded(const LoadedMap &loadedMap)
+{
+    // Results of superseded requests are dropped
+    if (loadedMap.requestId != m_requestId)
+        return;
+
+    const bool loaded = loadedMap.map != nullptr;
+    if (loaded)
+        loadImages(loadedMap);
+
+    setMap(loadedMap.map, loadedMap.objectTemplates, loadedMap.tilesetImages);
+    setError(loadedMap.error);
+    if (loaded)
+        setProgress(1.0);
+    setStatus(loaded ? Ready : Error);
+}
+
+void MapLoader::loadProgress(int requestId, qreal progress)
+{
+    if (requestId == m_requestId)
+        setProgress(progress);
+}
+
+/**
+ * Loads the images skipped by the worker thread, which need to be loaded on
+ * the GUI thread because they are stored as QPixmap.
+ */
+void MapLoader::loadImages(const LoadedMap &loadedMap)
+{
+    // The image cache is shared with the worker thread
+    QMutexLocker locker(&readMutex);
+
+    for (const Tiled::SharedTileset &tileset : loadedMap.tilesets) {
+        if (!tileset->isCollection()) {
+            tileset->loadImage();
+            continue;
+        }
 
-    Tiled::MapReader mapReader;
+        for (Tiled::Tile *tile : tileset->tiles()) {
+            if (tile->imageSource().isEmpty())
+                continue;
 
-    std::unique_ptr<Tiled::Map> map(mapReader.readMap(Tiled::urlToLocalFileOrQrc(source)));
-    Status status = map ? Ready : Error;
-    QString error = map ? QString() : mapReader.errorString();
+            const QString fileName = Tiled::urlToLocalFileOrQrc(tile->imageSource());
+            tileset->setTileImage(tile, Tiled::ImageCache::loadPixmap(fileName), tile->imageSource());
+        }
+    }
+
+    Tiled::LayerIterator iterator(loadedMap.map.get(), Tiled::Layer::ImageLayerType);
+    while (Tiled::Layer *layer = iterator.next()) {
+        auto imageLayer = static_cast<Tiled::ImageLayer*>(layer);
+        if (!imageLayer->imageSource().isEmpty())
+            imageLayer->loadFromImage(imageLayer->imageSource());
+    }
+}
+
+void MapLoader::setMap(std::shared_ptr<Tiled::Map> map,
+                       const QVector<std::shared_ptr<Tiled::ObjectTemplate>> &objectTemplates,
+                       const QHash<const Tiled::Tileset*, QImage> &images)
+{
+    if (!m_map && !map)
+        return;
 
-    const bool mapDiff = m_map != map;
-    const bool statusDiff = m_status != status;
-    const bool errorDiff = m_error != error;
+    {
+        QMutexLocker locker(&tilesetImagesMutex);
 
+        for (const Tiled::Tileset *tileset : qAsConst(m_tilesets))
+            tilesetImages.remove(tileset);
+        m_tilesets.clear();
+
+        for (auto it = images.begin(), it_end = images.end(); it != it_end; ++it) {
+            tilesetImages.insert(it.key(), it.value());
+            m_tilesets.append(it.key());
+        }
+    }
+
+    // The templates are replaced after the map that refers to them
     m_map = std::move(map);
+    m_objectTemplates = objectTemplates;
+    emit mapChanged(m_map.get());
+}
+
+void MapLoader::setStatus(Status status)
+{
+    if (m_status == status)
+        return;
+
     m_status = status;
-    m_error = error;
+    emit statusChanged(status);
+}
 
-    emit sourceChanged(source);
+void MapLoader::setProgress(qreal progress)
+{
+    if (m_progress == progress)
+        return;
 
-    if (mapDiff)
-        emit mapChanged(m_map.get());
-    if (statusDiff)
-        emit statusChanged(status);
-    if (errorDiff)
-        emit errorChanged(error);
+    m_progress = progress;
+    emit progressChanged(progress);
 }
+
+void MapLoader::setError(const QString &error)
+{
+    if (m_error == error)
+        return;
+
+    m_error = error;
+    emit errorChanged(error);
+}
+
+#include "maploader.moc"
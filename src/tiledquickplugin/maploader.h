@@ -20,29 +20,50 @@
 
 #pragma once
 
+#include <QHash>
+#include <QImage>
 #include <QObject>
+#include <QThread>
 #include <QUrl>
+#include <QVector>
 
 #include <memory>
 
 namespace Tiled {
 class Map;
+class ObjectTemplate;
+class Tileset;
 }
 
 namespace TiledQuick {
 
+class MapLoaderWorker;
+struct LoadedMap;
+
+/**
+ * Loads a map for display in Qt Quick.
+ *
+ * The map is read on a worker thread, which also decodes the tileset images,
+ * so that loading large maps doesn't block the user interface. Only the
+ * pixmaps, which can't be created on another thread, are created once the
+ * map has been read. The status
+ * changes to Loading until the map is ready, while progress reports the
+ * fraction of the map file that has been read.
+ */
 class MapLoader : public QObject
 {
     Q_OBJECT
 
     Q_PROPERTY(QUrl source READ source WRITE setSource NOTIFY sourceChanged)
-    Q_PROPERTY(Tiled::Map *map READ map NOTIFY sourceChanged)
+    Q_PROPERTY(Tiled::Map *map READ map NOTIFY mapChanged)
     Q_PROPERTY(Status status READ status NOTIFY statusChanged)
+    Q_PROPERTY(qreal progress READ progress NOTIFY progressChanged)
     Q_PROPERTY(QString error READ error NOTIFY errorChanged)
 
 public:
     enum Status {
         Null,
+        Loading,
         Ready,
         Error
     };
@@ -54,22 +75,45 @@ public:
     QUrl source() const;
     Tiled::Map *map() const;
     Status status() const;
+    qreal progress() const;
     QString error() const;
 
+    static QImage tilesetImage(const Tiled::Tileset *tileset);
+
 signals:
     void sourceChanged(const QUrl &source);
     void mapChanged(Tiled::Map *map);
     void statusChanged(Status status);
+    void progressChanged(qreal progress);
     void errorChanged(const QString &error);
 
+    void loadRequested(int requestId, const QString &fileName);
+
 public slots:
     void setSource(const QUrl &source);
 
 private:
+    void mapLoaded(const LoadedMap &loadedMap);
+    void loadProgress(int requestId, qreal progress);
+    void loadImages(const LoadedMap &loadedMap);
+
+    void setMap(std::shared_ptr<Tiled::Map> map,
+                const QVector<std::shared_ptr<Tiled::ObjectTemplate>> &objectTemplates,
+                const QHash<const Tiled::Tileset*, QImage> &tilesetImages);
+    void setStatus(Status status);
+    void setProgress(qreal progress);
+    void setError(const QString &error);
+
     QUrl m_source;
-    std::unique_ptr<Tiled::Map> m_map;
+    std::shared_ptr<Tiled::Map> m_map;
+    QVector<std::shared_ptr<Tiled::ObjectTemplate>> m_objectTemplates;
+    QList<const Tiled::Tileset*> m_tilesets;
     Status m_status;
+    qreal m_progress;
     QString m_error;
+    int m_requestId;
+    QThread m_thread;
+    MapLoaderWorker *m_worker;
 };
 
 
@@ -83,6 +127,11 @@ inline MapLoader::Status MapLoader::status() const
     return m_status;
 }
 
+inline qreal MapLoader::progress() const
+{
+    return m_progress;
+}
+
 inline QString MapLoader::error() const
 {
     return m_error;
@@ -27,6 +27,7 @@
 #include "maprenderer.h"
 
 #include "mapitem.h"
+#include "maploader.h"
 #include "tilesnode.h"
 
 #include <QtMath>
@@ -40,16 +41,30 @@ namespace {
 /**
  * Returns the texture of a given tileset, or 0 if the image has not been
  * loaded yet.
+ *
+ * New textures are only created while the given \a budget is above zero,
+ * which spreads the uploads for a newly loaded map over several frames.
  */
 static inline QSGTexture *tilesetTexture(Tileset *tileset,
-                                         QQuickWindow *window)
+                                         QQuickWindow *window,
+                                         int *budget)
 {
     static QHash<Tileset *, QSGTexture *> cache;
 
     QSGTexture *texture = cache.value(tileset);
     if (!texture) {
-        const QString imagePath(Tiled::urlToLocalFileOrQrc(tileset->imageSource()));
-        texture = window->createTextureFromImage(QImage(imagePath));
+        if (budget) {
+            if (*budget <= 0)
+                return nullptr;
+            --*budget;
+        }
+
+        // Prefer the image already decoded by the MapLoader
+        QImage image = MapLoader::tilesetImage(tileset);
+        if (image.isNull())
+            image = QImage(Tiled::urlToLocalFileOrQrc(tileset->imageSource()));
+
+        texture = window->createTextureFromImage(image);
         cache.insert(tileset, texture);
     }
     return texture;
@@ -61,8 +76,10 @@ static inline QSGTexture *tilesetTexture(Tileset *tileset,
  */
 struct TilesetHelper
 {
-    TilesetHelper(const MapItem *mapItem)
+    TilesetHelper(const MapItem *mapItem, int *textureBudget = nullptr)
         : mWindow(mapItem->window())
+        , mTextureBudget(textureBudget)
+        , mTexturesPending(false)
         , mTileset(nullptr)
         , mTexture(nullptr)
         , mMargin(0)
@@ -74,13 +91,16 @@ struct TilesetHelper
 
     Tileset *tileset() const { return mTileset; }
     QSGTexture *texture() const { return mTexture; }
+    bool texturesPending() const { return mTexturesPending; }
 
     void setTileset(Tileset *tileset)
     {
         mTileset = tileset;
-        mTexture = tilesetTexture(tileset, mWindow);
-        if (!mTexture)
+        mTexture = tilesetTexture(tileset, mWindow, mTextureBudget);
+        if (!mTexture) {
+            mTexturesPending |= mTextureBudget != nullptr;
             return;
+        }
 
         const int tileSpacing = tileset->tileSpacing();
         mMargin = tileset->margin();
@@ -104,6 +124,8 @@ struct TilesetHelper
 
 private:
     QQuickWindow *mWindow;
+    int *mTextureBudget;
+    bool mTexturesPending;
     Tileset *mTileset;
     QSGTexture *mTexture;
     int mMargin;
@@ -145,7 +167,10 @@ QSGNode *TileLayerItem::updatePaintNode(QSGNode *node,
     node = new QSGNode;
     node->setFlag(QSGNode::OwnedByParent);
 
-    TilesetHelper helper(static_cast<MapItem*>(parentItem()));
+    // Limit the number of textures created per frame, so that the visible
+    // part of a newly loaded map shows up without long stalls
+    int textureBudget = 1;
+    TilesetHelper helper(static_cast<MapItem*>(parentItem()), &textureBudget);
 
     QVector<TileData> tileData;
     tileData.reserve(TilesNode::MaxTileCount);
@@ -195,6 +220,10 @@ QSGNode *TileLayerItem::updatePaintNode(QSGNode *node,
     if (!tileData.isEmpty())
         node->appendChildNode(new TilesNode(helper.texture(), tileData));
 
+    // Schedule another frame to create the remaining textures
+    if (helper.texturesPending())
+        QMetaObject::invokeMethod(this, "update", Qt::QueuedConnection);
+
     return node;
 }
 
@@ -0,0 +1,102 @@
+/*
+ * main.cpp
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of the TMX Diff tool.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "pluginmanager.h"
+#include "tmxdiff.h"
+
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QGuiApplication>
+#include <QStringList>
+#include <QTextStream>
+#include <QUrl>
+
+using namespace Tiled;
+
+static QString localFile(const QString &fileNameOrUrl)
+{
+    const QUrl url(fileNameOrUrl);
+    return url.isLocalFile() ? url.toLocalFile() : fileNameOrUrl;
+}
+
+int main(int argc, char *argv[])
+{
+    QGuiApplication app(argc, argv);
+
+    app.setOrganizationDomain(QLatin1String("mapeditor.org"));
+    app.setApplicationName(QLatin1String("TmxDiff"));
+    app.setApplicationVersion(QLatin1String("1.0"));
+
+    PluginManager::instance()->loadPlugins();
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QCoreApplication::translate("main", "Compares two versions of a Tiled map. Exits with 0 when they are the same, 1 when they differ and 2 in case of an error."));
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addOptions({
+                          { "image",
+                            QCoreApplication::translate("main", "Renders the changed areas of the new map to an image, with the changes highlighted. Changes far apart are written to separate, numbered images."),
+                            QCoreApplication::translate("main", "file") },
+                          { { "s", "scale" },
+                            QCoreApplication::translate("main", "The scale of the image (default: 1)."),
+                            QCoreApplication::translate("main", "scale") },
+                      });
+    parser.addPositionalArgument("old", QCoreApplication::translate("main", "The old version of the map."));
+    parser.addPositionalArgument("new", QCoreApplication::translate("main", "The new version of the map."));
+    parser.process(app);
+
+    const QStringList args = parser.positionalArguments();
+    if (args.size() != 2)
+        parser.showHelp(2);
+
+    const QString oldFile = localFile(args.at(0));
+    const QString newFile = localFile(args.at(1));
+
+    if (oldFile.isEmpty() || newFile.isEmpty())
+        parser.showHelp(2);
+
+    TmxDiff tmxDiff;
+    tmxDiff.setImageFileName(parser.value(QLatin1String("image")));
+
+    if (parser.isSet(QLatin1String("scale"))) {
+        bool ok;
+        tmxDiff.setScale(parser.value(QLatin1String("scale")).toDouble(&ok));
+        if (!ok || tmxDiff.scale() <= 0.0) {
+            qWarning().noquote() << QCoreApplication::translate("main", "Invalid scale specified: \"%1\"").arg(parser.value(QLatin1String("scale")));
+            return 2;
+        }
+    }
+
+    const int result = tmxDiff.diff(oldFile, newFile);
+
+    QTextStream out(stdout);
+    for (const QString &line : tmxDiff.differences())
+        out << line << '\n';
+
+    return result;
+}
@@ -0,0 +1,793 @@
+/*
+ * tmxdiff.cpp
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of the TMX Diff tool.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "tmxdiff.h"
+
+#include "hexagonalrenderer.h"
+#include "imagelayer.h"
+#include "isometricrenderer.h"
+#include "map.h"
+#include "mapformat.h"
+#include "mapobject.h"
+#include "objectgroup.h"
+#include "objecttemplate.h"
+#include "orthogonalrenderer.h"
+#include "staggeredrenderer.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QImage>
+#include <QImageWriter>
+#include <QPainter>
+#include <QSet>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QtMath>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+using namespace Tiled;
+
+namespace {
+
+std::unique_ptr<MapRenderer> createRenderer(Map &map)
+{
+    switch (map.orientation()) {
+    case Map::Isometric:
+        return std::unique_ptr<MapRenderer>(new IsometricRenderer(&map));
+    case Map::Staggered:
+        return std::unique_ptr<MapRenderer>(new StaggeredRenderer(&map));
+    case Map::Hexagonal:
+        return std::unique_ptr<MapRenderer>(new HexagonalRenderer(&map));
+    case Map::Orthogonal:
+    default:
+        return std::unique_ptr<MapRenderer>(new OrthogonalRenderer(&map));
+    }
+}
+
+/**
+ * Matches the tilesets of the old map with those of the new map, so that
+ * cells can be compared between the two maps.
+ *
+ * External tilesets are matched by their file name, either as absolute path
+ * or relative to the map, so that a map can be compared with a revision
+ * checked out elsewhere. Embedded tilesets are matched by name.
+ *
+ * Chunk hashes identify tilesets by name, so equal hashes only mean
+ * equivalent chunks when the names are unique and each tileset is matched
+ * with one of the same name.
+ */
+class TilesetMapping
+{
+public:
+    TilesetMapping(const Map &oldMap, const Map &newMap)
+    {
+        const QDir oldDir = QFileInfo(oldMap.fileName).dir();
+        const QDir newDir = QFileInfo(newMap.fileName).dir();
+
+        QHash<QString, const Tileset*> newByFileName;
+        QHash<QString, const Tileset*> newByRelativeFileName;
+        QHash<QString, const Tileset*> newByName;
+
+        for (const SharedTileset &tileset : newMap.tilesets()) {
+            if (tileset->fileName().isEmpty()) {
+                newByName.insert(tileset->name(), tileset.data());
+            } else {
+                newByFileName.insert(tileset->fileName(), tileset.data());
+                newByRelativeFileName.insert(newDir.relativeFilePath(tileset->fileName()), tileset.data());
+            }
+        }
+
+        for (const SharedTileset &tileset : oldMap.tilesets()) {
+            const Tileset *match = nullptr;
+
+            if (tileset->fileName().isEmpty()) {
+                match = newByName.value(tileset->name());
+            } else {
+                match = newByFileName.value(tileset->fileName());
+                if (!match)
+                    match = newByRelativeFileName.value(oldDir.relativeFilePath(tileset->fileName()));
+            }
+
+            if (match)
+                mTilesets.insert(tileset.data(), match);
+        }
+
+        mHashesComparable = uniqueNames(oldMap) && uniqueNames(newMap) &&
+                mTilesets.size() == oldMap.tilesetCount();
+
+        for (auto it = mTilesets.cbegin(), it_end = mTilesets.cend(); it != it_end; ++it)
+            if (it.key()->name() != it.value()->name())
+                mHashesComparable = false;
+    }
+
+    bool hashesComparable() const { return mHashesComparable; }
+
+    bool equivalent(const Cell &oldCell, const Cell &newCell) const
+    {
+        if (oldCell.isEmpty() || newCell.isEmpty())
+            return oldCell.isEmpty() == newCell.isEmpty();
+
+        return mTilesets.value(oldCell.tileset()) == newCell.tileset() &&
+                oldCell.tileId() == newCell.tileId() &&
+                oldCell.flippedHorizontally() == newCell.flippedHorizontally() &&
+                oldCell.flippedVertically() == newCell.flippedVertically() &&
+                oldCell.flippedAntiDiagonally() == newCell.flippedAntiDiagonally() &&
+                oldCell.rotatedHexagonal120() == newCell.rotatedHexagonal120();
+    }
+
+private:
+    static bool uniqueNames(const Map &map)
+    {
+        QSet<QString> names;
+        for (const SharedTileset &tileset : map.tilesets()) {
+            if (names.contains(tileset->name()))
+                return false;
+            names.insert(tileset->name());
+        }
+        return true;
+    }
+
+    QHash<const Tileset*, const Tileset*> mTilesets;
+    bool mHashesComparable;
+};
+
+struct TileLayerPair
+{
+    const TileLayer *oldLayer;
+    const TileLayer *newLayer;
+};
+
+/**
+ * A chunk to compare, given by the index of its layer pair and the top-left
+ * of the chunk in local tile coordinates.
+ */
+struct ChunkToCompare
+{
+    int layerIndex;
+    QPoint start;
+};
+
+struct ChangedChunk
+{
+    int layerIndex;
+    QRect changedBounds;
+    int changedCells;
+};
+
+/**
+ * Compares a range of chunks. Several of these tasks run in parallel, each
+ * on a different range of chunks.
+ *
+ * Chunks with equal hashes are skipped, but only when both hashes are
+ * cached already. On freshly loaded maps no hash is cached yet, and
+ * computing the hashes of both chunks would cost more than comparing their
+ * cells.
+ */
+class CompareChunksTask : public QRunnable
+{
+public:
+    CompareChunksTask(const QVector<TileLayerPair> &layers,
+                      const QVector<ChunkToCompare> &chunks,
+                      int begin, int end,
+                      const TilesetMapping &mapping)
+        : mLayers(layers)
+        , mChunks(chunks)
+        , mBegin(begin)
+        , mEnd(end)
+        , mMapping(mapping)
+    {
+        setAutoDelete(false);
+    }
+
+    void run() override
+    {
+        for (int i = mBegin; i < mEnd; ++i)
+            compareChunk(mChunks.at(i));
+    }
+
+    QVector<ChangedChunk> changes;
+
+private:
+    void compareChunk(const ChunkToCompare &chunk)
+    {
+        const TileLayerPair &layers = mLayers.at(chunk.layerIndex);
+        const int startX = chunk.start.x();
+        const int startY = chunk.start.y();
+        const Chunk *oldChunk = layers.oldLayer->findChunk(startX, startY);
+        const Chunk *newChunk = layers.newLayer->findChunk(startX, startY);
+
+        if (oldChunk && newChunk && mMapping.hashesComparable() &&
+                oldChunk->hasCachedHash() && newChunk->hasCachedHash() &&
+                oldChunk->hash() == newChunk->hash()) {
+            return;
+        }
+
+        int minX = CHUNK_SIZE, minY = CHUNK_SIZE, maxX = -1, maxY = -1;
+        int changedCells = 0;
+
+        for (int y = 0; y < CHUNK_SIZE; ++y) {
+            for (int x = 0; x < CHUNK_SIZE; ++x) {
+                const Cell &oldCell = oldChunk ? oldChunk->cellAt(x, y) : Cell::empty;
+                const Cell &newCell = newChunk ? newChunk->cellAt(x, y) : Cell::empty;
+
+                if (mMapping.equivalent(oldCell, newCell))
+                    continue;
+
+                minX = std::min(minX, x);
+                minY = std::min(minY, y);
+                maxX = std::max(maxX, x);
+                maxY = std::max(maxY, y);
+                ++changedCells;
+            }
+        }
+
+        if (changedCells > 0) {
+            const QRect bounds(QPoint(startX + minX, startY + minY),
+                               QPoint(startX + maxX, startY + maxY));
+            changes.append(ChangedChunk { chunk.layerIndex, bounds, changedCells });
+        }
+    }
+
+    const QVector<TileLayerPair> &mLayers;
+    const QVector<ChunkToCompare> &mChunks;
+    const int mBegin;
+    const int mEnd;
+    const TilesetMapping &mMapping;
+};
+
+/**
+ * Compares the chunks of all given tile layer pairs, spreading the work over
+ * the available cores.
+ */
+QVector<ChangedChunk> compareTileLayers(const QVector<TileLayerPair> &layers,
+                                        const TilesetMapping &mapping)
+{
+    QVector<ChunkToCompare> chunks;
+
+    auto byPosition = [] (const QRect &a, const QRect &b) {
+        return a.y() != b.y() ? a.y() < b.y() : a.x() < b.x();
+    };
+
+    for (int i = 0; i < layers.size(); ++i) {
+        // Since every revision is above 0, these are all chunks of both layers
+        QVector<QRect> chunkRects = layers.at(i).oldLayer->changedChunks(0);
+        chunkRects += layers.at(i).newLayer->changedChunks(0);
+
+        std::sort(chunkRects.begin(), chunkRects.end(), byPosition);
+        chunkRects.erase(std::unique(chunkRects.begin(), chunkRects.end()), chunkRects.end());
+
+        for (const QRect &rect : qAsConst(chunkRects))
+            chunks.append(ChunkToCompare { i, rect.topLeft() });
+    }
+
+    QThreadPool threadPool;
+    const int taskCount = std::max(1, std::min(QThread::idealThreadCount(), chunks.size() / 64));
+    const int chunksPerTask = (chunks.size() + taskCount - 1) / taskCount;
+
+    std::vector<std::unique_ptr<CompareChunksTask>> tasks;
+    for (int begin = 0; begin < chunks.size(); begin += chunksPerTask) {
+        const int end = std::min(begin + chunksPerTask, chunks.size());
+        tasks.emplace_back(new CompareChunksTask(layers, chunks, begin, end, mapping));
+        threadPool.start(tasks.back().get());
+    }
+
+    threadPool.waitForDone();
+
+    QVector<ChangedChunk> changes;
+    for (const auto &task : tasks)
+        changes += task->changes;
+    return changes;
+}
+
+Layer *findMatchingLayer(const Map &map, const Layer *layer)
+{
+    for (Layer *candidate : map.allLayers()) {
+        if (candidate->layerType() != layer->layerType())
+            continue;
+
+        if (layer->id() > 0 ? candidate->id() == layer->id()
+                            : candidate->name() == layer->name())
+            return candidate;
+    }
+    return nullptr;
+}
+
+QString describe(const QVariant &value)
+{
+    const QVariant exportValue = toExportValue(value);
+
+    switch (exportValue.userType()) {
+    case QMetaType::QString:
+        return QLatin1Char('"') + exportValue.toString() + QLatin1Char('"');
+    case QMetaType::QPoint: {
+        const QPoint point = exportValue.toPoint();
+        return QStringLiteral("%1,%2").arg(point.x()).arg(point.y());
+    }
+    case QMetaType::QSize: {
+        const QSize size = exportValue.toSize();
+        return QStringLiteral("%1x%2").arg(size.width()).arg(size.height());
+    }
+    case QMetaType::QPointF: {
+        const QPointF point = exportValue.toPointF();
+        return QStringLiteral("%1,%2").arg(point.x()).arg(point.y());
+    }
+    case QMetaType::QSizeF: {
+        const QSizeF size = exportValue.toSizeF();
+        return QStringLiteral("%1x%2").arg(size.width()).arg(size.height());
+    }
+    default:
+        return exportValue.toString();
+    }
+}
+
+QString describe(const QRect &rect)
+{
+    return QStringLiteral("%1,%2 %3x%4").arg(rect.x()).arg(rect.y()).arg(rect.width()).arg(rect.height());
+}
+
+QString describe(const Layer *layer)
+{
+    return QStringLiteral("layer \"%1\"").arg(layer->name());
+}
+
+QString describe(const MapObject *object)
+{
+    if (object->name().isEmpty())
+        return QStringLiteral("object %1").arg(object->id());
+    return QStringLiteral("object %1 \"%2\"").arg(object->id()).arg(object->name());
+}
+
+/**
+ * Collects the differences as lines of text.
+ */
+class DiffReport
+{
+public:
+    explicit DiffReport(QStringList &lines)
+        : mLines(lines)
+    {}
+
+    int differences() const { return mLines.size(); }
+
+    void add(const QString &context, const QString &message)
+    {
+        mLines.append(context + QLatin1String(": ") + message);
+    }
+
+    template<typename T>
+    void compare(const QString &context, const char *what, const T &oldValue, const T &newValue)
+    {
+        if (oldValue != newValue) {
+            add(context, QStringLiteral("%1 changed from %2 to %3")
+                .arg(QLatin1String(what),
+                     describe(QVariant::fromValue(oldValue)),
+                     describe(QVariant::fromValue(newValue))));
+        }
+    }
+
+    void compareProperties(const QString &context,
+                           const Properties &oldProperties,
+                           const Properties &newProperties)
+    {
+        for (auto it = oldProperties.begin(), it_end = oldProperties.end(); it != it_end; ++it) {
+            auto newIt = newProperties.find(it.key());
+            if (newIt == newProperties.end()) {
+                add(context, QStringLiteral("property \"%1\" removed").arg(it.key()));
+                continue;
+            }
+
+            const QVariant oldValue = toExportValue(it.value());
+            const QVariant newValue = toExportValue(newIt.value());
+            if (oldValue.userType() != newValue.userType() || oldValue != newValue) {
+                add(context, QStringLiteral("property \"%1\" changed from %2 to %3")
+                    .arg(it.key(), describe(it.value()), describe(newIt.value())));
+            }
+        }
+
+        for (auto it = newProperties.begin(), it_end = newProperties.end(); it != it_end; ++it) {
+            if (!oldProperties.contains(it.key())) {
+                add(context, QStringLiteral("property \"%1\" added with value %2")
+                    .arg(it.key(), describe(it.value())));
+            }
+        }
+    }
+
+private:
+    QStringList &mLines;
+};
+
+QHash<int, MapObject*> objectsById(const Map &map)
+{
+    QHash<int, MapObject*> objects;
+    for (Layer *layer : map.objectGroups())
+        for (MapObject *object : static_cast<ObjectGroup*>(layer)->objects())
+            objects.insert(object->id(), object);
+    return objects;
+}
+
+QString templateFileName(const MapObject *object)
+{
+    const ObjectTemplate *objectTemplate = object->objectTemplate();
+    return objectTemplate ? objectTemplate->fileName() : QString();
+}
+
+/**
+ * Groups the given areas into clusters of areas that are close to each
+ * other, and returns the bounds of each cluster.
+ *
+ * This avoids rendering the potentially huge space between changes that
+ * are far apart.
+ */
+QVector<QRectF> clusterAreas(const Map &map, const QVector<QRectF> &changedAreas)
+{
+    const qreal margin = 4 * std::max(map.tileWidth(), map.tileHeight());
+
+    QVector<QRectF> clusters;
+
+    for (const QRectF &area : changedAreas) {
+        QRectF bounds = area;
+
+        // Absorb all clusters close to this area, which may in turn bring
+        // the bounds close to other clusters
+        bool merged = true;
+        while (merged) {
+            merged = false;
+            const QRectF extended = bounds.adjusted(-margin, -margin, margin, margin);
+
+            for (int i = clusters.size() - 1; i >= 0; --i) {
+                if (extended.intersects(clusters.at(i))) {
+                    bounds |= clusters.at(i);
+                    clusters.remove(i);
+                    merged = true;
+                }
+            }
+        }
+
+        clusters.append(bounds);
+    }
+
+    auto byPosition = [] (const QRectF &a, const QRectF &b) {
+        return a.y() != b.y() ? a.y() < b.y() : a.x() < b.x();
+    };
+    std::sort(clusters.begin(), clusters.end(), byPosition);
+
+    return clusters;
+}
+
+} // anonymous namespace
+
+
+TmxDiff::TmxDiff()
+    : mScale(1.0)
+{
+}
+
+/**
+ * Compares the two given maps. Returns 0 when they are the same, 1 when
+ * differences were found and 2 in case of an error, like diff does.
+ *
+ * The differences found are available through differences().
+ */
+int TmxDiff::diff(const QString &oldFileName, const QString &newFileName)
+{
+    mDifferences.clear();
+
+    QString errorString;
+
+    std::unique_ptr<Map> oldMap { readMap(oldFileName, &errorString) };
+    if (!oldMap) {
+        qWarning("Error while reading \"%s\":\n%s",
+                 qUtf8Printable(oldFileName),
+                 qUtf8Printable(errorString));
+        return 2;
+    }
+
+    std::unique_ptr<Map> newMap { readMap(newFileName, &errorString) };
+    if (!newMap) {
+        qWarning("Error while reading \"%s\":\n%s",
+                 qUtf8Printable(newFileName),
+                 qUtf8Printable(errorString));
+        return 2;
+    }
+
+    DiffReport report(mDifferences);
+    const TilesetMapping tilesetMapping(*oldMap, *newMap);
+    std::unique_ptr<MapRenderer> renderer = createRenderer(*newMap);
+    QVector<QRectF> changedAreas;
+
+    // Compare the map attributes
+    const QString mapContext = QStringLiteral("map");
+    report.compare(mapContext, "orientation", orientationToString(oldMap->orientation()), orientationToString(newMap->orientation()));
+    report.compare(mapContext, "width", oldMap->width(), newMap->width());
+    report.compare(mapContext, "height", oldMap->height(), newMap->height());
+    report.compare(mapContext, "tile width", oldMap->tileWidth(), newMap->tileWidth());
+    report.compare(mapContext, "tile height", oldMap->tileHeight(), newMap->tileHeight());
+    report.compare(mapContext, "infinite", oldMap->infinite(), newMap->infinite());
+    report.compare(mapContext, "background color", oldMap->backgroundColor(), newMap->backgroundColor());
+    report.compareProperties(mapContext, oldMap->properties(), newMap->properties());
+
+    // Compare the layers
+    QVector<TileLayerPair> tileLayers;
+
+    for (Layer *oldLayer : oldMap->allLayers()) {
+        if (!findMatchingLayer(*newMap, oldLayer))
+            report.add(describe(oldLayer), QStringLiteral("removed"));
+    }
+
+    for (Layer *newLayer : newMap->allLayers()) {
+        const Layer *oldLayer = findMatchingLayer(*oldMap, newLayer);
+        const QString context = describe(newLayer);
+
+        if (!oldLayer) {
+            report.add(context, QStringLiteral("added"));
+
+            if (const TileLayer *tileLayer = newLayer->asTileLayer()) {
+                if (!tileLayer->isEmpty()) {
+                    changedAreas.append(renderer->boundingRect(tileLayer->bounds())
+                                        .translated(newLayer->totalOffset().toPoint()));
+                }
+            }
+            continue;
+        }
+
+        report.compare(context, "name", oldLayer->name(), newLayer->name());
+        report.compare(context, "position", oldLayer->position(), newLayer->position());
+        report.compare(context, "offset", oldLayer->offset(), newLayer->offset());
+        report.compare(context, "opacity", oldLayer->opacity(), newLayer->opacity());
+        report.compare(context, "visible", oldLayer->isVisible(), newLayer->isVisible());
+        report.compare(context, "locked", oldLayer->isLocked(), newLayer->isLocked());
+        report.compareProperties(context, oldLayer->properties(), newLayer->properties());
+
+        if (const TileLayer *newTileLayer = newLayer->asTileLayer()) {
+            const TileLayer *oldTileLayer = static_cast<const TileLayer*>(oldLayer);
+            report.compare(context, "size", oldTileLayer->size(), newTileLayer->size());
+            tileLayers.append(TileLayerPair { oldTileLayer, newTileLayer });
+        }
+    }
+
+    // Compare the tiles
+    const QVector<ChangedChunk> changedChunks = compareTileLayers(tileLayers, tilesetMapping);
+
+    for (int i = 0; i < changedChunks.size(); ) {
+        const int layerIndex = changedChunks.at(i).layerIndex;
+        const TileLayer *layer = tileLayers.at(layerIndex).newLayer;
+
+        int changedCells = 0;
+        QStringList areas;
+
+        for (; i < changedChunks.size() && changedChunks.at(i).layerIndex == layerIndex; ++i) {
+            const ChangedChunk &chunk = changedChunks.at(i);
+            changedCells += chunk.changedCells;
+            areas.append(describe(chunk.changedBounds));
+            changedAreas.append(renderer->boundingRect(chunk.changedBounds.translated(layer->position()))
+                                .translated(layer->totalOffset().toPoint()));
+        }
+
+        report.add(describe(layer), QStringLiteral("%1 tiles changed in %2")
+                   .arg(changedCells)
+                   .arg(areas.join(QLatin1String("; "))));
+    }
+
+    // Compare the objects
+    const QHash<int, MapObject*> oldObjects = objectsById(*oldMap);
+    const QHash<int, MapObject*> newObjects = objectsById(*newMap);
+
+    QList<int> oldIds = oldObjects.keys();
+    std::sort(oldIds.begin(), oldIds.end());
+
+    for (int id : qAsConst(oldIds)) {
+        const MapObject *oldObject = oldObjects.value(id);
+        if (!newObjects.contains(id)) {
+            report.add(describe(oldObject), QStringLiteral("removed"));
+            changedAreas.append(renderer->boundingRect(oldObject).translated(oldObject->objectGroup()->totalOffset()));
+        }
+    }
+
+    QList<int> newIds = newObjects.keys();
+    std::sort(newIds.begin(), newIds.end());
+
+    for (int id : qAsConst(newIds)) {
+        const MapObject *newObject = newObjects.value(id);
+        const MapObject *oldObject = oldObjects.value(id);
+        const QString context = describe(newObject);
+        const QRectF area = renderer->boundingRect(newObject).translated(newObject->objectGroup()->totalOffset());
+
+        if (!oldObject) {
+            report.add(context, QStringLiteral("added"));
+            changedAreas.append(area);
+            continue;
+        }
+
+        const int differences = report.differences();
+
+        const ObjectGroup *oldGroup = oldObject->objectGroup();
+        const ObjectGroup *newGroup = newObject->objectGroup();
+        if (findMatchingLayer(*oldMap, newGroup) != oldGroup) {
+            report.add(context, QStringLiteral("moved from %1 to %2")
+                       .arg(describe(oldGroup), describe(newGroup)));
+        }
+
+        report.compare(context, "name", oldObject->name(), newObject->name());
+        report.compare(context, "type", oldObject->type(), newObject->type());
+        report.compare(context, "position", oldObject->position(), newObject->position());
+        report.compare(context, "size", oldObject->size(), newObject->size());
+        report.compare(context, "rotation", oldObject->rotation(), newObject->rotation());
+        report.compare(context, "visible", oldObject->isVisible(), newObject->isVisible());
+        report.compare(context, "shape", int(oldObject->shape()), int(newObject->shape()));
+        report.compare(context, "template", templateFileName(oldObject), templateFileName(newObject));
+
+        if (oldObject->polygon() != newObject->polygon())
+            report.add(context, QStringLiteral("polygon changed"));
+        if (oldObject->textData().text != newObject->textData().text)
+            report.add(context, QStringLiteral("text changed"));
+        if (!tilesetMapping.equivalent(oldObject->cell(), newObject->cell()))
+            report.add(context, QStringLiteral("tile changed"));
+
+        report.compareProperties(context, oldObject->properties(), newObject->properties());
+
+        if (report.differences() != differences) {
+            changedAreas.append(renderer->boundingRect(oldObject).translated(oldGroup->totalOffset()));
+            changedAreas.append(area);
+        }
+    }
+
+    if (!mImageFileName.isEmpty() && !changedAreas.isEmpty())
+        if (!writeImage(*newMap, *renderer, changedAreas))
+            return 2;
+
+    return report.differences() > 0 ? 1 : 0;
+}
+
+/**
+ * Renders the parts of the new map that changed to the image file, with the
+ * changed areas highlighted.
+ *
+ * Changed areas close to each other are rendered together, and each such
+ * cluster is written to its own image. When there is more than one cluster,
+ * the images are numbered, like "changes-1.png" and "changes-2.png".
+ */
+bool TmxDiff::writeImage(const Map &map,
+                         MapRenderer &renderer,
+                         const QVector<QRectF> &changedAreas) const
+{
+    const QVector<QRectF> clusters = clusterAreas(map, changedAreas);
+
+    for (int i = 0; i < clusters.size(); ++i) {
+        QString fileName = mImageFileName;
+        if (clusters.size() > 1) {
+            const QFileInfo fileInfo(mImageFileName);
+            QString baseName = fileInfo.completeBaseName() + QLatin1Char('-') + QString::number(i + 1);
+            if (!fileInfo.suffix().isEmpty())
+                baseName += QLatin1Char('.') + fileInfo.suffix();
+            fileName = fileInfo.dir().filePath(baseName);
+        }
+
+        const QImage image = renderArea(map, renderer, clusters.at(i), changedAreas);
+        if (image.isNull()) {
+            const QSizeF size = clusters.at(i).size() * mScale;
+            qWarning("Error while writing \"%s\": Could not create an image of %dx%d pixels",
+                     qUtf8Printable(fileName),
+                     qCeil(size.width()), qCeil(size.height()));
+            return false;
+        }
+
+        QImageWriter imageWriter(fileName);
+
+        if (!imageWriter.canWrite())
+            imageWriter.setFormat("png");
+
+        if (!imageWriter.write(image)) {
+            qWarning("Error while writing \"%s\": %s",
+                     qUtf8Printable(fileName),
+                     qUtf8Printable(imageWriter.errorString()));
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Renders the given area of the map, highlighting the changed areas within
+ * it. Returns a null image when the image could not be allocated.
+ */
+QImage TmxDiff::renderArea(const Map &map,
+                           MapRenderer &renderer,
+                           const QRectF &bounds,
+                           const QVector<QRectF> &changedAreas) const
+{
+    const QSize imageSize = (bounds.size() * mScale).toSize().expandedTo(QSize(1, 1));
+    QImage image(imageSize, QImage::Format_ARGB32);
+    if (image.isNull())
+        return image;
+
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    painter.setTransform(QTransform::fromScale(mScale, mScale));
+    painter.translate(-bounds.topLeft());
+
+    LayerIterator iterator(&map);
+    while (Layer *layer = iterator.next()) {
+        if (layer->isGroupLayer() || layer->isHidden())
+            continue;
+
+        const QPointF offset = layer->totalOffset();
+        const QRectF exposed = bounds.translated(-offset);
+
+        painter.save();
+        painter.setOpacity(layer->effectiveOpacity());
+        painter.translate(offset);
+
+        if (const TileLayer *tileLayer = layer->asTileLayer()) {
+            renderer.drawTileLayer(&painter, tileLayer, exposed);
+        } else if (const ImageLayer *imageLayer = layer->asImageLayer()) {
+            renderer.drawImageLayer(&painter, imageLayer, exposed);
+        } else if (const ObjectGroup *objectGroup = layer->asObjectGroup()) {
+            for (const MapObject *object : objectGroup->objects()) {
+                if (!object->isVisible() || !renderer.boundingRect(object).intersects(exposed))
+                    continue;
+
+                if (object->rotation() != qreal(0)) {
+                    const QPointF origin = renderer.pixelToScreenCoords(object->position());
+                    painter.save();
+                    painter.translate(origin);
+                    painter.rotate(object->rotation());
+                    painter.translate(-origin);
+                }
+
+                renderer.drawMapObject(&painter, object, object->effectiveColor());
+
+                if (object->rotation() != qreal(0))
+                    painter.restore();
+            }
+        }
+
+        painter.restore();
+    }
+
+    QPen pen(Qt::red);
+    pen.setCosmetic(true);
+    painter.setPen(pen);
+    painter.setBrush(QColor(255, 0, 0, 64));
+
+    for (const QRectF &area : changedAreas)
+        if (area.intersects(bounds))
+            painter.drawRect(area);
+
+    painter.end();
+
+    return image;
+}
@@ -0,0 +1,76 @@
+/*
+ * tmxdiff.h
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of the TMX Diff tool.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <QImage>
+#include <QRectF>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace Tiled {
+class Map;
+class MapRenderer;
+}
+
+/**
+ * Compares two versions of a map and reports the differences in its tiles,
+ * objects and properties.
+ *
+ * Tile layers are compared chunk by chunk, with the chunks spread over
+ * multiple threads. Objects are matched by their ID and layers by their ID
+ * or otherwise their name.
+ */
+class TmxDiff
+{
+public:
+    TmxDiff();
+
+    const QString &imageFileName() const { return mImageFileName; }
+    qreal scale() const { return mScale; }
+    const QStringList &differences() const { return mDifferences; }
+
+    void setImageFileName(const QString &fileName) { mImageFileName = fileName; }
+    void setScale(qreal scale) { mScale = scale; }
+
+    int diff(const QString &oldFileName, const QString &newFileName);
+
+private:
+    bool writeImage(const Tiled::Map &map,
+                    Tiled::MapRenderer &renderer,
+                    const QVector<QRectF> &changedAreas) const;
+    QImage renderArea(const Tiled::Map &map,
+                      Tiled::MapRenderer &renderer,
+                      const QRectF &bounds,
+                      const QVector<QRectF> &changedAreas) const;
+
+    QString mImageFileName;
+    qreal mScale;
+    QStringList mDifferences;
+};
@@ -0,0 +1,2 @@
+<?xml version="1.0" encoding="UTF-8"?>
+<tileset version="1.2" name="tiles" tilewidth="32" tileheight="32" tilecount="0" columns="0"/>
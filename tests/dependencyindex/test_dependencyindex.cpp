@@ -0,0 +1,162 @@
+#include "dependencyindex.h"
+
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+
+class test_DependencyIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void dependencies();
+    void usages();
+    void brokenLinks();
+    void saveAndLoad();
+    void update();
+
+private:
+    QString path(const QString &fileName) const;
+    void writeFile(const QString &fileName, const QByteArray &contents);
+
+    QTemporaryDir mDir;
+    DependencyIndex mIndex;
+};
+
+void test_DependencyIndex::initTestCase()
+{
+    QVERIFY(mDir.isValid());
+
+    writeFile("tiles.tsx",
+              "<tileset name=\"tiles\" tilewidth=\"32\" tileheight=\"32\">\n"
+              " <image source=\"tiles.png\" width=\"64\" height=\"64\"/>\n"
+              " <tile id=\"0\" type=\"wall\"/>\n"
+              "</tileset>\n");
+    writeFile("tiles.png", QByteArray());
+
+    writeFile("tree.tx",
+              "<template>\n"
+              " <tileset firstgid=\"1\" source=\"tiles.tsx\"/>\n"
+              " <object gid=\"1\" width=\"32\" height=\"32\"/>\n"
+              "</template>\n");
+
+    writeFile("maps/level.tmx",
+              "<map width=\"2\" height=\"2\" tilewidth=\"32\" tileheight=\"32\">\n"
+              " <tileset firstgid=\"1\" source=\"../missing.tsx\"/>\n"
+              " <layer name=\"Ground\" width=\"2\" height=\"2\">\n"
+              "  <data><tile gid=\"1\"/><tile gid=\"1\"/><tile/><tile/></data>\n"
+              " </layer>\n"
+              " <objectgroup name=\"Objects\">\n"
+              "  <object id=\"1\" template=\"../tree.tx\" x=\"0\" y=\"0\"/>\n"
+              "  <object id=\"2\" type=\"spawn\" x=\"0\" y=\"0\"/>\n"
+              " </objectgroup>\n"
+              " <imagelayer name=\"Background\">\n"
+              "  <image source=\"../tiles.png\"/>\n"
+              " </imagelayer>\n"
+              "</map>\n");
+
+    writeFile("maps/level.json",
+              "{ \"type\": \"map\",\n"
+              "  \"tilesets\": [ { \"firstgid\": 1, \"source\": \"../tiles.tsx\" } ],\n"
+              "  \"layers\": [ { \"type\": \"tilelayer\", \"data\": [ 1, 0, 0, 1 ] } ] }\n");
+
+    writeFile("maps/notes.json", "{ \"notes\": [] }\n");
+
+    mIndex.setObjectTypesFile(path("objecttypes.xml"));
+    mIndex.scan(QStringList { mDir.path() });
+}
+
+void test_DependencyIndex::dependencies()
+{
+    QCOMPARE(mIndex.files(), QStringList() << path("maps/level.json")
+                                           << path("maps/level.tmx")
+                                           << path("tiles.tsx")
+                                           << path("tree.tx"));
+
+    const auto dependencies = mIndex.dependencies(path("maps/level.tmx"));
+    QCOMPARE(dependencies.size(), 3);
+    QCOMPARE(dependencies.at(0).type, DependencyIndex::TilesetReference);
+    QCOMPARE(dependencies.at(0).fileName, path("missing.tsx"));
+    QCOMPARE(dependencies.at(1).type, DependencyIndex::TemplateReference);
+    QCOMPARE(dependencies.at(1).fileName, path("tree.tx"));
+    QCOMPARE(dependencies.at(2).type, DependencyIndex::ImageReference);
+    QCOMPARE(dependencies.at(2).fileName, path("tiles.png"));
+
+    QCOMPARE(mIndex.dependents(path("tiles.tsx")), QStringList() << path("maps/level.json")
+                                                                 << path("tree.tx"));
+    QCOMPARE(mIndex.dependents(path("objecttypes.xml")), QStringList() << path("maps/level.tmx")
+                                                                       << path("tiles.tsx"));
+}
+
+void test_DependencyIndex::usages()
+{
+    // The TMX map uses the tileset through its template
+    QCOMPARE(mIndex.usages(path("tiles.tsx")), QStringList() << path("maps/level.json")
+                                                             << path("maps/level.tmx")
+                                                             << path("tree.tx"));
+    QCOMPARE(mIndex.usages(path("tiles.png")), QStringList() << path("maps/level.json")
+                                                             << path("maps/level.tmx")
+                                                             << path("tiles.tsx")
+                                                             << path("tree.tx"));
+}
+
+void test_DependencyIndex::brokenLinks()
+{
+    const auto links = mIndex.brokenLinks();
+    QCOMPARE(links.size(), 1);
+    QCOMPARE(links.first().fileName, path("maps/level.tmx"));
+    QCOMPARE(links.first().dependency.fileName, path("missing.tsx"));
+}
+
+void test_DependencyIndex::saveAndLoad()
+{
+    const QString indexFile = path("index.json");
+    QVERIFY(mIndex.save(indexFile));
+
+    DependencyIndex index;
+    index.setObjectTypesFile(mIndex.objectTypesFile());
+    QVERIFY(index.load(indexFile));
+
+    QCOMPARE(index.files(), mIndex.files());
+    QCOMPARE(index.usages(path("tiles.tsx")), mIndex.usages(path("tiles.tsx")));
+    QCOMPARE(index.dependents(path("objecttypes.xml")), mIndex.dependents(path("objecttypes.xml")));
+}
+
+void test_DependencyIndex::update()
+{
+    writeFile("maps/level.tmx",
+              "<map width=\"2\" height=\"2\" tilewidth=\"32\" tileheight=\"32\">\n"
+              " <tileset firstgid=\"1\" source=\"../tiles.tsx\"/>\n"
+              "</map>\n");
+    mIndex.update(QStringList { path("maps/level.tmx") });
+
+    QCOMPARE(mIndex.dependents(path("tree.tx")), QStringList());
+    QCOMPARE(mIndex.dependents(path("tiles.tsx")), QStringList() << path("maps/level.json")
+                                                                 << path("maps/level.tmx")
+                                                                 << path("tree.tx"));
+    QVERIFY(mIndex.brokenLinks().isEmpty());
+
+    QVERIFY(QFile::remove(path("maps/level.json")));
+    mIndex.scan(QStringList { mDir.path() });
+    QVERIFY(!mIndex.files().contains(path("maps/level.json")));
+}
+
+QString test_DependencyIndex::path(const QString &fileName) const
+{
+    return QDir::cleanPath(QDir(mDir.path()).absoluteFilePath(fileName));
+}
+
+void test_DependencyIndex::writeFile(const QString &fileName, const QByteArray &contents)
+{
+    const QString filePath = path(fileName);
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+
+    QFile file(filePath);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(contents);
+}
+
+QTEST_MAIN(test_DependencyIndex)
+#include "test_dependencyindex.moc"
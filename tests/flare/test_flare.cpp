@@ -0,0 +1,85 @@
+#include "flareplugin.h"
+#include "map.h"
+#include "tilelayer.h"
+
+#include <QImage>
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+
+class test_Flare : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void readMap_data();
+    void readMap();
+
+private:
+    QTemporaryDir mDir;
+};
+
+void test_Flare::initTestCase()
+{
+    QVERIFY(mDir.isValid());
+
+    QImage tilesetImage(64, 32, QImage::Format_ARGB32);
+    tilesetImage.fill(Qt::white);
+    QVERIFY(tilesetImage.save(QDir(mDir.path()).filePath("tiles.png")));
+}
+
+void test_Flare::readMap_data()
+{
+    QTest::addColumn<QByteArray>("prefix");
+
+    QTest::newRow("plain") << QByteArray();
+    QTest::newRow("byte order mark") << QByteArray("\xEF\xBB\xBF");
+}
+
+void test_Flare::readMap()
+{
+    QFETCH(QByteArray, prefix);
+
+    const QString fileName = QDir(mDir.path()).filePath("map.txt");
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(prefix);
+    file.write("[header]\r\n"
+               "width=3\r\n"
+               "height=2\r\n"
+               "tilewidth=32\r\n"
+               "tileheight=32\r\n"
+               "orientation=orthogonal\r\n"
+               "\r\n"
+               "[tilesets]\r\n"
+               "tileset=tiles.png,32,32,0,0\r\n"
+               "\r\n"
+               "[layer]\r\n"
+               "type=ground\r\n"
+               "data=\r\n"
+               "1,0,2\r\n"
+               "0,2,1\r\n");
+    file.close();
+
+    Flare::FlarePlugin plugin;
+    const std::unique_ptr<Map> map = plugin.read(fileName);
+
+    QVERIFY2(map, qUtf8Printable(plugin.errorString()));
+    QCOMPARE(map->width(), 3);
+    QCOMPARE(map->height(), 2);
+    QCOMPARE(map->layerCount(), 1);
+
+    const TileLayer *tileLayer = map->layerAt(0)->asTileLayer();
+    QVERIFY(tileLayer);
+    QCOMPARE(tileLayer->cellAt(0, 0).tileId(), 0);
+    QVERIFY(tileLayer->cellAt(1, 0).isEmpty());
+    QCOMPARE(tileLayer->cellAt(2, 0).tileId(), 1);
+    QCOMPARE(tileLayer->cellAt(1, 1).tileId(), 1);
+    QCOMPARE(tileLayer->cellAt(2, 1).tileId(), 0);
+}
+
+QTEST_MAIN(test_Flare)
+#include "test_flare.moc"
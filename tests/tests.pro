@@ -1,4 +1,8 @@
 TEMPLATE=subdirs
 SUBDIRS = \
+    dependencyindex \
+    flare \
     mapreader \
-    staggeredrenderer
+    staggeredrenderer \
+    tilelayer \
+    tmxdiff
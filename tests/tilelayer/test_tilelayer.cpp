@@ -0,0 +1,220 @@
+#include "randompicker.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+
+class test_TileLayer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void forEachCellInRow();
+    void forEachCellInColumn();
+    void forEachNonEmptyCell();
+    void changedChunks();
+    void chunkHash();
+
+    void benchmarkCellAt();
+    void benchmarkForEachCellInRow();
+    void benchmarkRandomPickerBuild();
+    void benchmarkRandomPickerPick();
+
+private:
+    SharedTileset mTileset;
+    TileLayer *mSparseLayer;
+    TileLayer *mFullLayer;
+};
+
+void test_TileLayer::initTestCase()
+{
+    mTileset = Tileset::create(QString(), 32, 32);
+
+    // A layer with a few cells, spread over several chunks
+    mSparseLayer = new TileLayer(QString(), 0, 0, 50, 40);
+    mSparseLayer->setCell(0, 0, Cell(mTileset.data(), 1));
+    mSparseLayer->setCell(15, 3, Cell(mTileset.data(), 2));
+    mSparseLayer->setCell(16, 3, Cell(mTileset.data(), 3));
+    mSparseLayer->setCell(33, 20, Cell(mTileset.data(), 4));
+    mSparseLayer->setCell(49, 39, Cell(mTileset.data(), 5));
+
+    // A large layer without any empty cells
+    mFullLayer = new TileLayer(QString(), 0, 0, 1000, 1000);
+    for (int y = 0; y < mFullLayer->height(); ++y)
+        for (int x = 0; x < mFullLayer->width(); ++x)
+            mFullLayer->setCell(x, y, Cell(mTileset.data(), (x + y) % 16));
+}
+
+void test_TileLayer::cleanupTestCase()
+{
+    delete mSparseLayer;
+    mSparseLayer = nullptr;
+    delete mFullLayer;
+    mFullLayer = nullptr;
+    mTileset.reset();
+}
+
+void test_TileLayer::forEachCellInRow()
+{
+    for (int y = 0; y < mSparseLayer->height(); ++y) {
+        int expectedX = 3;
+
+        mSparseLayer->forEachCellInRow(y, 3, 47, [&] (int x, const Cell &cell) {
+            QCOMPARE(x, expectedX);
+            QCOMPARE(cell, mSparseLayer->cellAt(x, y));
+            ++expectedX;
+        });
+
+        QCOMPARE(expectedX, 47);
+    }
+}
+
+void test_TileLayer::forEachCellInColumn()
+{
+    for (int x = 0; x < mSparseLayer->width(); ++x) {
+        int expectedY = 1;
+
+        mSparseLayer->forEachCellInColumn(x, 1, 40, [&] (int y, const Cell &cell) {
+            QCOMPARE(y, expectedY);
+            QCOMPARE(cell, mSparseLayer->cellAt(x, y));
+            ++expectedY;
+        });
+
+        QCOMPARE(expectedY, 40);
+    }
+}
+
+void test_TileLayer::forEachNonEmptyCell()
+{
+    QHash<QPoint, int> tileIds;
+
+    mSparseLayer->forEachNonEmptyCell([&] (int x, int y, const Cell &cell) {
+        QVERIFY(!tileIds.contains(QPoint(x, y)));
+        tileIds.insert(QPoint(x, y), cell.tileId());
+    });
+
+    QCOMPARE(tileIds.size(), 5);
+    QCOMPARE(tileIds.value(QPoint(0, 0)), 1);
+    QCOMPARE(tileIds.value(QPoint(15, 3)), 2);
+    QCOMPARE(tileIds.value(QPoint(16, 3)), 3);
+    QCOMPARE(tileIds.value(QPoint(33, 20)), 4);
+    QCOMPARE(tileIds.value(QPoint(49, 39)), 5);
+}
+
+void test_TileLayer::changedChunks()
+{
+    TileLayer layer(QString(), 0, 0, 64, 64);
+    layer.setCell(1, 1, Cell(mTileset.data(), 1));
+    layer.setCell(40, 40, Cell(mTileset.data(), 2));
+    QCOMPARE(layer.changedChunks(0).size(), 2);
+
+    const quint64 revision = Chunk::currentRevision();
+    QVERIFY(layer.changedChunks(revision).isEmpty());
+
+    layer.setCell(2, 3, Cell(mTileset.data(), 3));
+    QCOMPARE(layer.changedChunks(revision), QVector<QRect>() << QRect(0, 0, 16, 16));
+
+    layer.setCell(20, 1, Cell(mTileset.data(), 4));
+    QCOMPARE(layer.changedChunks(revision), QVector<QRect>()
+             << QRect(0, 0, 16, 16)
+             << QRect(16, 0, 16, 16));
+
+    // Removed chunks are reported as well, until they are discarded
+    const quint64 clearRevision = Chunk::currentRevision();
+    layer.clear();
+    QCOMPARE(layer.changedChunks(clearRevision).size(), 3);
+
+    layer.discardRemovedChunks(Chunk::currentRevision());
+    QVERIFY(layer.changedChunks(clearRevision).isEmpty());
+}
+
+void test_TileLayer::chunkHash()
+{
+    TileLayer layer1(QString(), 0, 0, 32, 32);
+    TileLayer layer2(QString(), 0, 0, 32, 32);
+
+    layer1.setCell(5, 5, Cell(mTileset.data(), 1));
+    layer2.setCell(5, 5, Cell(mTileset.data(), 1));
+    QCOMPARE(layer1.findChunk(5, 5)->hash(), layer2.findChunk(5, 5)->hash());
+
+    Cell flipped(mTileset.data(), 1);
+    flipped.setFlippedHorizontally(true);
+    layer2.setCell(5, 5, flipped);
+    QVERIFY(layer1.findChunk(5, 5)->hash() != layer2.findChunk(5, 5)->hash());
+
+    layer2.setCell(5, 5, Cell(mTileset.data(), 1));
+    QCOMPARE(layer1.findChunk(5, 5)->hash(), layer2.findChunk(5, 5)->hash());
+
+    // The same tileset stored elsewhere results in the same hash
+    SharedTileset copy = mTileset->clone();
+    copy->setFileName(QStringLiteral("/elsewhere/tileset.tsx"));
+    layer2.setCell(5, 5, Cell(copy.data(), 1));
+    QCOMPARE(layer1.findChunk(5, 5)->hash(), layer2.findChunk(5, 5)->hash());
+}
+
+void test_TileLayer::benchmarkCellAt()
+{
+    qint64 sum = 0;
+
+    QBENCHMARK {
+        for (int y = 0; y < mFullLayer->height(); ++y)
+            for (int x = 0; x < mFullLayer->width(); ++x)
+                sum += mFullLayer->cellAt(x, y).tileId();
+    }
+
+    QVERIFY(sum > 0);
+}
+
+void test_TileLayer::benchmarkForEachCellInRow()
+{
+    qint64 sum = 0;
+
+    QBENCHMARK {
+        for (int y = 0; y < mFullLayer->height(); ++y) {
+            mFullLayer->forEachCellInRow(y, 0, mFullLayer->width(), [&] (int, const Cell &cell) {
+                sum += cell.tileId();
+            });
+        }
+    }
+
+    QVERIFY(sum > 0);
+}
+
+void test_TileLayer::benchmarkRandomPickerBuild()
+{
+    qint64 sum = 0;
+
+    // Includes building the alias table, which happens on the first pick
+    QBENCHMARK {
+        RandomPicker<int> picker;
+        for (int i = 0; i < 1000; ++i)
+            picker.add(i, 1 + i % 7);
+        sum += picker.pick();
+    }
+
+    QVERIFY(sum >= 0);
+}
+
+void test_TileLayer::benchmarkRandomPickerPick()
+{
+    RandomPicker<int> picker;
+    for (int i = 0; i < 1000; ++i)
+        picker.add(i, 1 + i % 7);
+
+    qint64 sum = 0;
+
+    QBENCHMARK {
+        for (int i = 0; i < 10000; ++i)
+            sum += picker.pick();
+    }
+
+    QVERIFY(sum > 0);
+}
+
+QTEST_MAIN(test_TileLayer)
+#include "test_tilelayer.moc"
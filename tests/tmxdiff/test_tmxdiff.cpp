@@ -0,0 +1,54 @@
+#include "tmxdiff.h"
+
+#include <QtTest/QtTest>
+
+class test_TmxDiff : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void sameMap();
+    void changedMap();
+    void changedImages();
+};
+
+void test_TmxDiff::sameMap()
+{
+    TmxDiff tmxDiff;
+    QCOMPARE(tmxDiff.diff("../data/tmxdiff/old/map.tmx",
+                          "../data/tmxdiff/old/map.tmx"), 0);
+    QVERIFY(tmxDiff.differences().isEmpty());
+}
+
+void test_TmxDiff::changedMap()
+{
+    // The maps use their own copy of the tileset, like two checkouts would
+    TmxDiff tmxDiff;
+    QCOMPARE(tmxDiff.diff("../data/tmxdiff/old/map.tmx",
+                          "../data/tmxdiff/new/map.tmx"), 1);
+    QCOMPARE(tmxDiff.differences(), QStringList()
+             << "layer \"Ground\": 3 tiles changed in 2,3 1x1; 35,20 2x2"
+             << "object 1 \"Chest\": position changed from 64,64 to 96,64");
+}
+
+void test_TmxDiff::changedImages()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    // The changes near the top-left are far from those near the bottom-right
+    TmxDiff tmxDiff;
+    tmxDiff.setImageFileName(QDir(dir.path()).filePath("changes.png"));
+    QCOMPARE(tmxDiff.diff("../data/tmxdiff/old/map.tmx",
+                          "../data/tmxdiff/new/map.tmx"), 1);
+
+    QCOMPARE(QDir(dir.path()).entryList(QDir::Files), QStringList()
+             << "changes-1.png"
+             << "changes-2.png");
+
+    const QImage image(QDir(dir.path()).filePath("changes-2.png"));
+    QCOMPARE(image.size(), QSize(64, 64));
+}
+
+QTEST_MAIN(test_TmxDiff)
+#include "test_tmxdiff.moc"